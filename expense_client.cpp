@@ -0,0 +1,209 @@
+// -------------------------------------------
+// MSCS 632 Advanced Programming Languages
+// Group Project
+// Expense Tracker App - Query Daemon Client
+// -------------------------------------------
+//
+// Sends a single request to a tracker started with --serve and prints the
+// result in the same format as the interactive menu.
+
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <cstdlib>
+#include <cmath>
+#include "expense_protocol.h"
+using namespace std;
+
+/**
+ * Prints command-line usage
+ */
+void printUsage(const char *program)
+{
+    cout << "Usage: " << program << " SOCKET COMMAND [ARGS]\n"
+         << "Commands:\n"
+         << "  ping\n"
+         << "  add DATE AMOUNT CATEGORY DESCRIPTION\n"
+         << "  all\n"
+         << "  range START_DATE END_DATE\n"
+         << "  category NAME\n"
+         << "  summary\n"
+         << "  total START_DATE END_DATE [CATEGORY]\n";
+}
+
+/**
+ * Formats whole cents as dollars with two decimals
+ */
+string formatCents(int64_t cents)
+{
+    ostringstream out;
+    out << (cents < 0 ? "-" : "") << llabs(cents) / 100 << "." << setw(2) << setfill('0') << llabs(cents) % 100;
+    return out.str();
+}
+
+/**
+ * Prints the rows of a list/filter response
+ * @return false if the payload is malformed
+ */
+bool printRows(FrameReader &reader)
+{
+    uint32_t count = reader.getU32();
+    for (uint32_t i = 0; i < count && reader.ok(); ++i)
+    {
+        string date = reader.getDate();
+        int64_t cents = reader.getI64();
+        string category = reader.getString();
+        string description = reader.getString();
+        if (!reader.ok())
+            break;
+        cout << "Date: " << date
+             << ", Amount: $" << formatCents(cents)
+             << ", Category: " << category
+             << ", Description: " << description << endl;
+    }
+    if (reader.ok() && count == 0)
+    {
+        cout << "No expenses found.\n";
+    }
+    return reader.ok();
+}
+
+/**
+ * Prints a summary response
+ * @return false if the payload is malformed
+ */
+bool printSummary(FrameReader &reader)
+{
+    uint32_t count = reader.getU32();
+    cout << "Category Breakdown" << endl;
+    for (uint32_t i = 0; i < count && reader.ok(); ++i)
+    {
+        string category = reader.getString();
+        int64_t cents = reader.getI64();
+        if (reader.ok())
+            cout << " - " << category << ": $" << formatCents(cents) << endl;
+    }
+    int64_t total = reader.getI64();
+    if (reader.ok())
+        cout << "\nTotal Expenses: $" << formatCents(total) << endl;
+    return reader.ok();
+}
+
+/**
+ * Prints a range total response
+ * @return false if the payload is malformed
+ */
+bool printRangeTotal(FrameReader &reader)
+{
+    int64_t count = reader.getI64();
+    int64_t total = reader.getI64();
+    if (reader.ok())
+    {
+        cout << "Expenses: " << count << "\n";
+        cout << "Total:    $" << formatCents(total) << endl;
+    }
+    return reader.ok();
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc < 3)
+    {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    string socketPath = argv[1];
+    string command = argv[2];
+    FrameWriter writer;
+
+    // Build the request frame
+    if (command == "ping" && argc == 3)
+    {
+        writer.begin(OP_PING);
+    }
+    else if (command == "add" && argc == 7)
+    {
+        double amount = atof(argv[4]);
+        writer.begin(OP_ADD);
+        writer.putDate(argv[3]);
+        writer.putI64(static_cast<int64_t>(llround(amount * 100.0)));
+        writer.putString(argv[5]);
+        writer.putString(argv[6]);
+    }
+    else if (command == "all" && argc == 3)
+    {
+        writer.begin(OP_LIST_ALL);
+    }
+    else if (command == "range" && argc == 5)
+    {
+        writer.begin(OP_FILTER_DATE);
+        writer.putDate(argv[3]);
+        writer.putDate(argv[4]);
+    }
+    else if (command == "category" && argc == 4)
+    {
+        writer.begin(OP_FILTER_CATEGORY);
+        writer.putString(argv[3]);
+    }
+    else if (command == "summary" && argc == 3)
+    {
+        writer.begin(OP_SUMMARY);
+    }
+    else if (command == "total" && (argc == 5 || argc == 6))
+    {
+        writer.begin(OP_RANGE_TOTAL);
+        writer.putDate(argv[3]);
+        writer.putDate(argv[4]);
+        writer.putString(argc == 6 ? argv[5] : "");
+    }
+    else
+    {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    int fd = connectToDaemon(socketPath);
+    if (fd < 0)
+    {
+        cout << "Error: Cannot connect to " << socketPath << ": " << strerror(errno) << "\n";
+        return 1;
+    }
+
+    string response;
+    if (!sendAll(fd, writer.finish()) || !receiveFrame(fd, response))
+    {
+        cout << "Error: Connection to server lost.\n";
+        close(fd);
+        return 1;
+    }
+    close(fd);
+
+    // Decode and print the response
+    FrameReader reader(response.data() + 1, response.size() - 1);
+    if (static_cast<uint8_t>(response[0]) == STATUS_ERROR)
+    {
+        cout << reader.getString() << "\n";
+        return 1;
+    }
+
+    bool ok = true;
+    if (command == "ping")
+        cout << "pong" << endl;
+    else if (command == "add")
+        cout << "Expense added successfully!" << endl;
+    else if (command == "summary")
+        ok = printSummary(reader);
+    else if (command == "total")
+        ok = printRangeTotal(reader);
+    else
+        ok = printRows(reader);
+
+    if (!ok)
+    {
+        cout << "Error: Malformed response from server.\n";
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,3521 @@
+// -------------------------------------------
+// MSCS 632 Advanced Programming Languages
+// Group Project
+// Expense Tracker App - Engine Library
+// -------------------------------------------
+//
+// Storage, ledger, alert and query engine behind the console app and its
+// server mode. Other programs can include this header to embed a tracker.
+//
+// Queries do not print or copy. They return ExpenseSelection row-ID spans,
+// ExpenseRef views into the stored rows, or aggregate structs. Formatting
+// is left to the caller; the console UI in expense_tracker.cpp is one such
+// caller.
+
+#ifndef EXPENSE_ENGINE_H
+#define EXPENSE_ENGINE_H
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <limits>
+#include <cstdlib>
+#include <cstring>
+#include <cstdio>
+#include <cctype>
+#include <cstddef>
+#include <cmath>
+#include <stdint.h>
+#include <stdexcept>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <algorithm>
+#include <iterator>
+#include <functional>
+#include <map>
+#include <unordered_map>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#ifdef _WIN32
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+
+// Constants for array management
+const int INITIAL_CAPACITY = 10;          // Starting size for dynamic array
+const int DOUBLING_CAPACITY_LIMIT = 4096; // Arrays this large grow by a quarter instead of doubling
+const int MAX_CATEGORIES = 50;            // Maximum number of unique categories
+
+// Category totals produced by ExpenseTracker::computeSummary
+struct ExpenseSummary
+{
+    std::string categories[MAX_CATEGORIES]; // Unique categories in first-seen order
+    int64_t totalCents[MAX_CATEGORIES];     // Total per category, in cents
+    int categoryCount;                      // Number of entries used in the arrays
+    int64_t totalExpensesCents;             // Overall total, in cents
+    bool overflow;                          // True if some categories did not fit
+};
+
+// ============================================================================
+// DATE VALIDATION
+// ============================================================================
+//
+// Dates are kept as day numbers (days since 1970-01-01), so filtering and
+// range queries compare integers. A YYYY-MM-DD field is checked and
+// converted in one SWAR pass: its eight digits are gathered into a 64-bit
+// word, validated with two masked compares and folded into year, month and
+// day with one multiply. Month lengths and offsets come from tables and the
+// leap-year test reads the year's digit pairs, so no divide instruction is
+// needed and parseDateFields() can stream a whole import block through it.
+
+const size_t DATE_FIELD_LENGTH = 10; // "YYYY-MM-DD"
+
+/**
+ * Converts a civil date to days since 1970-01-01 (proleptic Gregorian)
+ */
+inline int32_t daysFromCivil(int year, int month, int day)
+{
+    year -= month <= 2;
+    int era = (year >= 0 ? year : year - 399) / 400;
+    int yearOfEra = year - era * 400;
+    int dayOfYear = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    int dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+    return era * 146097 + dayOfEra - 719468;
+}
+
+/**
+ * Validates a YYYY-MM-DD field and converts it to a day number
+ * @param text At least DATE_FIELD_LENGTH readable bytes (need not be NUL-terminated)
+ * @param day Set to days since 1970-01-01 when the date is valid
+ * @return false unless the field is a real calendar date
+ */
+inline bool parseDateField(const char *text, int32_t &day)
+{
+    static const uint8_t MONTH_LENGTH[13] = {0, 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+    static const uint16_t DAYS_BEFORE_MONTH[13] = {0, 0, 31, 59, 90, 120, 151, 181, 212, 243, 273, 304, 334};
+    const unsigned char *bytes = reinterpret_cast<const unsigned char *>(text);
+
+    // Bytes 0-7 ("YYYY-MM-") as a little-endian word whatever the host order
+    // (compilers merge the shifts into a single load)
+    uint64_t word = static_cast<uint64_t>(bytes[0]) | static_cast<uint64_t>(bytes[1]) << 8 |
+                    static_cast<uint64_t>(bytes[2]) << 16 | static_cast<uint64_t>(bytes[3]) << 24 |
+                    static_cast<uint64_t>(bytes[4]) << 32 | static_cast<uint64_t>(bytes[5]) << 40 |
+                    static_cast<uint64_t>(bytes[6]) << 48 | static_cast<uint64_t>(bytes[7]) << 56;
+
+    // Drop the dashes (bytes 4 and 7) and append the day: YYYYMMDD
+    uint64_t digits = (word & 0x00000000FFFFFFFFULL) | ((word >> 8) & 0x0000FFFF00000000ULL) |
+                      static_cast<uint64_t>(bytes[8]) << 48 | static_cast<uint64_t>(bytes[9]) << 56;
+
+    // Every digit byte must be 0x30-0x39: high nibble 3, and adding 6 must not carry into it
+    bool shape = ((word >> 32) & 0xFF) == '-' && (word >> 56) == '-';
+    bool allDigits = (digits & 0xF0F0F0F0F0F0F0F0ULL) == 0x3030303030303030ULL &&
+                     ((digits + 0x0606060606060606ULL) & 0xF0F0F0F0F0F0F0F0ULL) == 0x3030303030303030ULL;
+
+    // Fold digit pairs into two-digit values in bytes 0, 2, 4 and 6
+    uint64_t pairs = digits - 0x3030303030303030ULL;
+    pairs = (pairs * 10 + (pairs >> 8)) & 0x00FF00FF00FF00FFULL;
+    unsigned century = static_cast<unsigned>(pairs & 0xFF);
+    unsigned yearOfCentury = static_cast<unsigned>((pairs >> 16) & 0xFF);
+    unsigned month = static_cast<unsigned>((pairs >> 32) & 0xFF);
+    unsigned dayOfMonth = static_cast<unsigned>((pairs >> 48) & 0xFF);
+
+    // Leap years: every 4th year, except centuries not divisible by 400
+    bool leap = ((yearOfCentury == 0 ? century : yearOfCentury) & 3) == 0;
+    bool monthValid = month - 1 < 12;
+    unsigned tableMonth = monthValid ? month : 0;
+    bool dayValid = dayOfMonth - 1 < MONTH_LENGTH[tableMonth] + static_cast<unsigned>(tableMonth == 2 && leap);
+    if (!(shape & allDigits & monthValid & dayValid))
+        return false;
+
+    // Days since -0400-01-01, keeping every operand non-negative, then rebased to 1970
+    unsigned year = century * 100 + yearOfCentury;
+    unsigned previousYears = year + 399;
+    unsigned leapDays = 1 + previousYears / 4 - previousYears / 100 + previousYears / 400;
+    unsigned days = (year + 400) * 365 + leapDays + DAYS_BEFORE_MONTH[month] + (month > 2 && leap) + dayOfMonth - 1;
+    day = static_cast<int32_t>(days) - 865625;
+    return true;
+}
+
+/**
+ * Validates and converts a block of YYYY-MM-DD fields
+ * Each field is converted independently, so the loop pipelines across fields
+ * instead of stalling on the per-character branches of a scalar parser.
+ * @param fields count pointers to DATE_FIELD_LENGTH readable bytes each
+ * @param days Receives each valid field's day number
+ * @param valid Receives 1 for each valid field, 0 otherwise
+ * @return Number of valid fields
+ */
+inline size_t parseDateFields(const char *const *fields, size_t count, int32_t *days, uint8_t *valid)
+{
+    size_t validCount = 0;
+    for (size_t i = 0; i < count; ++i)
+    {
+        valid[i] = parseDateField(fields[i], days[i]);
+        validCount += valid[i];
+    }
+    return validCount;
+}
+
+/**
+ * Converts a YYYY-MM-DD string to a day number
+ * @param day Set to days since 1970-01-01
+ * @return false if the string is not a real calendar date
+ */
+inline bool parseDayNumber(const std::string &date, int32_t &day)
+{
+    return date.length() == DATE_FIELD_LENGTH && parseDateField(date.data(), day);
+}
+
+/**
+ * Validates a date (YYYY-MM-DD format, real calendar day)
+ * @param date String to validate
+ * @return true if date is valid, false otherwise
+ */
+inline bool isValidDate(const std::string &date)
+{
+    int32_t day;
+    return parseDayNumber(date, day);
+}
+
+// ============================================================================
+// COMPACT ROW ENCODING
+// ============================================================================
+//
+// Rows are stored in 16 bytes instead of as three strings and a float
+// (roughly 100 bytes before any heap payload):
+//
+//   day                int32   days since 1970-01-01
+//   cents              int32   amount in whole cents
+//   descriptionOffset  uint32  start of the description in the table's pool
+//   descriptionLength  uint16  description length in bytes
+//   categoryId         uint16  index into the shared CategoryTable
+//
+// Descriptions live in an append-only pool per table, and repeated
+// descriptions are stored once.
+
+const int32_t MAX_AMOUNT_CENTS = 2147483647;       // Largest amount a row can hold
+const size_t MAX_DESCRIPTION_LENGTH = 65535;       // Longer descriptions are truncated
+const int MAX_CATEGORY_IDS = 65536;                // Category IDs are 16 bits
+const int CATEGORY_CHUNK_SIZE = 256;               // Names allocated per CategoryTable chunk
+
+/**
+ * Estimates the heap bytes owned by a string beyond the object itself
+ * (strings short enough for the small-string buffer own nothing)
+ */
+inline size_t stringHeapBytes(const std::string &value)
+{
+    return value.capacity() > 15 ? value.capacity() + 1 : 0;
+}
+
+struct CompactExpense
+{
+    int32_t day;                // Days since 1970-01-01
+    int32_t cents;              // Amount in cents
+    uint32_t descriptionOffset; // Offset into the owning table's StringPool
+    uint16_t descriptionLength; // Description length in bytes
+    uint16_t categoryId;        // Index into the CategoryTable
+};
+static_assert(sizeof(CompactExpense) == 16, "CompactExpense should stay 16 bytes per row");
+
+/**
+ * Converts days since 1970-01-01 back to a civil date (inverse of daysFromCivil)
+ */
+inline void civilFromDays(int32_t dayNumber, int &year, int &month, int &day)
+{
+    int days = dayNumber + 719468;
+    int era = (days >= 0 ? days : days - 146096) / 146097;
+    int dayOfEra = days - era * 146097;
+    int yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365;
+    int dayOfYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+    int monthIndex = (5 * dayOfYear + 2) / 153;
+    day = dayOfYear - (153 * monthIndex + 2) / 5 + 1;
+    month = monthIndex < 10 ? monthIndex + 3 : monthIndex - 9;
+    year = yearOfEra + era * 400 + (month <= 2);
+}
+
+/**
+ * Writes a day number as YYYY-MM-DD
+ * @param out Buffer of at least 11 bytes; receives a NUL-terminated date
+ */
+inline void formatDayNumber(int32_t dayNumber, char *out)
+{
+    int year, month, day;
+    civilFromDays(dayNumber, year, month, day);
+
+    out[0] = static_cast<char>('0' + year / 1000 % 10);
+    out[1] = static_cast<char>('0' + year / 100 % 10);
+    out[2] = static_cast<char>('0' + year / 10 % 10);
+    out[3] = static_cast<char>('0' + year % 10);
+    out[4] = '-';
+    out[5] = static_cast<char>('0' + month / 10);
+    out[6] = static_cast<char>('0' + month % 10);
+    out[7] = '-';
+    out[8] = static_cast<char>('0' + day / 10);
+    out[9] = static_cast<char>('0' + day % 10);
+    out[10] = '\0';
+}
+
+/**
+ * @return The day number formatted as YYYY-MM-DD
+ */
+inline std::string dayNumberToDate(int32_t dayNumber)
+{
+    char buffer[11];
+    formatDayNumber(dayNumber, buffer);
+    return std::string(buffer, 10);
+}
+
+/**
+ * Converts a float amount to whole cents
+ * @return Rounded cents (not range-checked)
+ */
+inline int64_t amountToCents(float amount)
+{
+    return static_cast<int64_t>(llround(static_cast<double>(amount) * 100.0));
+}
+
+/**
+ * Formats cents as a dollar amount with two decimals (no currency symbol)
+ */
+inline std::string formatCents(int64_t cents)
+{
+    std::ostringstream out;
+    out << (cents < 0 ? "-" : "") << (cents < 0 ? -cents : cents) / 100 << '.'
+        << std::setw(2) << std::setfill('0') << (cents < 0 ? -cents : cents) % 100;
+    return out.str();
+}
+
+/**
+ * Interning table mapping category names to 16-bit IDs
+ * Names are stored in fixed-size chunks that never move, so readers can call
+ * getName() without locking while another thread interns new names.
+ */
+class CategoryTable
+{
+public:
+    CategoryTable() : count(0)
+    {
+        for (int i = 0; i < MAX_CATEGORY_IDS / CATEGORY_CHUNK_SIZE; ++i)
+            chunks[i] = NULL;
+    }
+
+    ~CategoryTable()
+    {
+        for (int i = 0; i < MAX_CATEGORY_IDS / CATEGORY_CHUNK_SIZE; ++i)
+            delete[] chunks[i];
+    }
+
+    /**
+     * Returns the ID for a category, adding it if it is new
+     * @throws length_error if all 65536 IDs are in use
+     */
+    uint16_t intern(const std::string &name)
+    {
+        std::lock_guard<std::mutex> guard(tableMutex);
+        std::unordered_map<std::string, uint16_t>::const_iterator it = ids.find(name);
+        if (it != ids.end())
+            return it->second;
+
+        int id = count.load(std::memory_order_relaxed);
+        if (id >= MAX_CATEGORY_IDS)
+            throw std::length_error("too many distinct categories");
+        int chunk = id / CATEGORY_CHUNK_SIZE;
+        if (chunks[chunk] == NULL)
+            chunks[chunk] = new std::string[CATEGORY_CHUNK_SIZE];
+        chunks[chunk][id % CATEGORY_CHUNK_SIZE] = name;
+        ids[name] = static_cast<uint16_t>(id);
+        count.store(id + 1, std::memory_order_release); // Publish the name to readers
+        return static_cast<uint16_t>(id);
+    }
+
+    /**
+     * @return The ID of an existing category, or -1 if it was never added
+     */
+    int find(const std::string &name) const
+    {
+        std::lock_guard<std::mutex> guard(tableMutex);
+        std::unordered_map<std::string, uint16_t>::const_iterator it = ids.find(name);
+        return it == ids.end() ? -1 : it->second;
+    }
+
+    const std::string &getName(uint16_t id) const
+    {
+        return chunks[id / CATEGORY_CHUNK_SIZE][id % CATEGORY_CHUNK_SIZE];
+    }
+
+    int getCount() const { return count.load(std::memory_order_acquire); }
+
+    /**
+     * @return Approximate bytes used by names, chunks and the lookup map
+     */
+    size_t memoryBytes() const
+    {
+        std::lock_guard<std::mutex> guard(tableMutex);
+        size_t bytes = sizeof(*this);
+        int used = count.load(std::memory_order_relaxed);
+        bytes += ((used + CATEGORY_CHUNK_SIZE - 1) / CATEGORY_CHUNK_SIZE) * CATEGORY_CHUNK_SIZE * sizeof(std::string);
+        for (int id = 0; id < used; ++id)
+            bytes += 2 * stringHeapBytes(getName(static_cast<uint16_t>(id))) + sizeof(std::string) + 32; // Map node
+        return bytes;
+    }
+
+private:
+    std::string *chunks[MAX_CATEGORY_IDS / CATEGORY_CHUNK_SIZE];
+    std::atomic<int> count;
+    std::unordered_map<std::string, uint16_t> ids;
+    mutable std::mutex tableMutex;
+
+    CategoryTable(const CategoryTable &);
+    CategoryTable &operator=(const CategoryTable &);
+};
+
+/**
+ * Append-only byte pool with 32-bit offsets that stores each distinct string once
+ * Duplicates are found through an open-addressing index of (offset, length)
+ * pairs, which costs 8 bytes per slot rather than a node per string.
+ */
+class StringPool
+{
+public:
+    StringPool() : data(NULL), capacity(0), size(0), slots(NULL), slotCount(0), uniqueCount(0) {}
+
+    ~StringPool()
+    {
+        delete[] data;
+        delete[] slots;
+    }
+
+    /**
+     * Stores a string (or finds an identical one already stored)
+     * @return Offset of the bytes in the pool
+     * @throws length_error if the pool would pass 4 GB
+     */
+    uint32_t intern(const char *text, uint16_t length)
+    {
+        if (uniqueCount * 2 >= slotCount)
+            growIndex();
+
+        uint32_t mask = slotCount - 1;
+        uint32_t slot = hashBytes(text, length) & mask;
+        while (slots[slot].length != EMPTY_SLOT)
+        {
+            if (slots[slot].length == length && memcmp(data + slots[slot].offset, text, length) == 0)
+                return slots[slot].offset;
+            slot = (slot + 1) & mask;
+        }
+
+        uint32_t offset = appendBytes(text, length);
+        slots[slot].offset = offset;
+        slots[slot].length = length;
+        uniqueCount++;
+        return offset;
+    }
+
+    const char *at(uint32_t offset) const { return data + offset; }
+    uint32_t getUniqueCount() const { return uniqueCount; }
+    size_t getPoolBytes() const { return capacity; }
+    size_t getIndexBytes() const { return static_cast<size_t>(slotCount) * sizeof(Slot); }
+
+private:
+    struct Slot
+    {
+        uint32_t offset;
+        uint32_t length; // EMPTY_SLOT marks an unused slot
+    };
+    static const uint32_t EMPTY_SLOT = 0xFFFFFFFFu;
+
+    char *data;
+    size_t capacity;
+    size_t size;
+    Slot *slots;
+    uint32_t slotCount; // Always a power of two
+    uint32_t uniqueCount;
+
+    /**
+     * FNV-1a over the string bytes
+     */
+    static uint32_t hashBytes(const char *text, uint16_t length)
+    {
+        uint32_t hash = 2166136261u;
+        for (uint16_t i = 0; i < length; ++i)
+        {
+            hash ^= static_cast<uint8_t>(text[i]);
+            hash *= 16777619u;
+        }
+        return hash;
+    }
+
+    uint32_t appendBytes(const char *text, uint16_t length)
+    {
+        if (size + length > 0xFFFFFFFFu)
+            throw std::length_error("description pool is full");
+        if (size + length > capacity)
+        {
+            // Double the buffer, like ExpenseTable does for rows
+            size_t newCapacity = capacity == 0 ? 1024 : capacity * 2;
+            while (newCapacity < size + length)
+                newCapacity *= 2;
+            if (newCapacity > 0xFFFFFFFFu)
+                newCapacity = 0xFFFFFFFFu;
+            char *newData = new char[newCapacity];
+            if (size > 0)
+                memcpy(newData, data, size);
+            delete[] data;
+            data = newData;
+            capacity = newCapacity;
+        }
+        memcpy(data + size, text, length);
+        uint32_t offset = static_cast<uint32_t>(size);
+        size += length;
+        return offset;
+    }
+
+    void growIndex()
+    {
+        uint32_t newCount = slotCount == 0 ? 64 : slotCount * 2;
+        Slot *newSlots = new Slot[newCount];
+        for (uint32_t i = 0; i < newCount; ++i)
+            newSlots[i].length = EMPTY_SLOT;
+
+        uint32_t mask = newCount - 1;
+        for (uint32_t i = 0; i < slotCount; ++i)
+        {
+            if (slots[i].length == EMPTY_SLOT)
+                continue;
+            uint32_t slot = hashBytes(data + slots[i].offset, static_cast<uint16_t>(slots[i].length)) & mask;
+            while (newSlots[slot].length != EMPTY_SLOT)
+                slot = (slot + 1) & mask;
+            newSlots[slot] = slots[i];
+        }
+        delete[] slots;
+        slots = newSlots;
+        slotCount = newCount;
+    }
+
+    StringPool(const StringPool &);
+    StringPool &operator=(const StringPool &);
+};
+
+/**
+ * Borrowed view of one stored expense
+ * Points into the table's storage; valid only while that storage is unchanged
+ * (i.e. for the duration of a forEachExpense callback)
+ */
+struct ExpenseRef
+{
+    int32_t day;              // Days since 1970-01-01
+    int32_t cents;            // Amount in cents
+    uint16_t categoryId;      // ID in the tracker's CategoryTable
+    const std::string *category;   // Interned category name
+    const char *description;  // Description bytes (not NUL-terminated)
+    uint16_t descriptionLength;
+
+    std::string date() const { return dayNumberToDate(day); }
+    double amount() const { return cents / 100.0; }
+    std::string descriptionText() const { return std::string(description, descriptionLength); }
+};
+
+// Storage statistics reported by the Memory Report menu option
+struct MemoryReport
+{
+    size_t rows;              // Rows currently held in memory
+    size_t rowBytes;          // Bytes of CompactExpense arrays (including spare capacity)
+    size_t poolBytes;         // Bytes of description pools
+    size_t poolIndexBytes;    // Bytes of description de-duplication indexes
+    size_t uniqueDescriptions; // Distinct descriptions across pools
+    size_t categoryBytes;     // Bytes of the category interning table
+    int categoryCount;        // Distinct categories
+    int segmentCount;         // Ledger segments registered (0 without a ledger)
+    int loadedSegments;       // Ledger segments currently in memory
+    size_t memoryCap;         // Ledger memory cap in bytes (0 without a ledger)
+    size_t rangeIndexBytes;   // Bytes of the date-range totals index (0 until first used)
+};
+
+// ============================================================================
+// EXPENSE STORAGE
+// ============================================================================
+
+/**
+ * Growable array of compact rows with manual memory management
+ * Used for the in-memory tracker and for each loaded ledger segment
+ */
+class ExpenseTable
+{
+public:
+    /**
+     * Constructor - starts with an empty array of INITIAL_CAPACITY rows
+     * @param categories Interning table shared by every table of a tracker
+     */
+    explicit ExpenseTable(CategoryTable &categories) : categories(categories)
+    {
+        capacity = INITIAL_CAPACITY;
+        size = 0;
+        rows = new CompactExpense[capacity]; // Dynamic array of rows
+    }
+
+    /**
+     * Destructor - cleans up dynamically allocated memory
+     */
+    ~ExpenseTable()
+    {
+        delete[] rows;
+    }
+
+    /**
+     * Encodes an expense and stores it at the end of the array
+     * @param day Expense date as a day number
+     * @param cents Expense amount in cents
+     * @param categoryId ID returned by the shared CategoryTable
+     * @throws bad_alloc if memory cannot be allocated
+     * @throws length_error if the description pool is full
+     */
+    void append(int32_t day, int32_t cents, uint16_t categoryId, const std::string &description)
+    {
+        // Resize array if needed
+        if (size >= capacity)
+        {
+            resize();
+        }
+
+        size_t length = description.size() > MAX_DESCRIPTION_LENGTH ? MAX_DESCRIPTION_LENGTH : description.size();
+        CompactExpense &row = rows[size];
+        row.day = day;
+        row.cents = cents;
+        row.categoryId = categoryId;
+        row.descriptionLength = static_cast<uint16_t>(length);
+        row.descriptionOffset = descriptions.intern(description.data(), row.descriptionLength);
+        size++;
+    }
+
+    int getSize() const { return size; }
+
+    /**
+     * @return A borrowed view of the row at index
+     */
+    ExpenseRef at(int index) const
+    {
+        const CompactExpense &row = rows[index];
+        ExpenseRef ref;
+        ref.day = row.day;
+        ref.cents = row.cents;
+        ref.categoryId = row.categoryId;
+        ref.category = &categories.getName(row.categoryId);
+        ref.description = descriptions.at(row.descriptionOffset);
+        ref.descriptionLength = row.descriptionLength;
+        return ref;
+    }
+
+    /**
+     * @return Bytes of memory held by the rows, the pool and its index
+     */
+    size_t memoryBytes() const
+    {
+        return capacity * sizeof(CompactExpense) + descriptions.getPoolBytes() + descriptions.getIndexBytes();
+    }
+
+    /**
+     * Adds this table's storage to a memory report
+     */
+    void addToReport(MemoryReport &report) const
+    {
+        report.rows += size;
+        report.rowBytes += capacity * sizeof(CompactExpense);
+        report.poolBytes += descriptions.getPoolBytes();
+        report.poolIndexBytes += descriptions.getIndexBytes();
+        report.uniqueDescriptions += descriptions.getUniqueCount();
+    }
+
+private:
+    CompactExpense *rows;        // Dynamic array of rows
+    int capacity;                // Current capacity of the array
+    int size;                    // Current number of rows stored
+    StringPool descriptions;     // Description bytes referenced by rows
+    CategoryTable &categories;   // Shared category names
+
+    /**
+     * Doubles the capacity of the rows array
+     * Called when array becomes full
+     */
+    void resize()
+    {
+        // Small arrays double; large ones grow by a quarter so spare capacity
+        // stays under 4 bytes per row (bad_alloc propagates to the caller,
+        // which reports it)
+        int newCapacity = capacity < DOUBLING_CAPACITY_LIMIT ? capacity * 2 : capacity + capacity / 4;
+        CompactExpense *newArr = new CompactExpense[newCapacity];
+
+        // Copy existing rows to new array
+        memcpy(newArr, rows, size * sizeof(CompactExpense));
+
+        // Delete old array and update pointer
+        delete[] rows;
+        rows = newArr;
+        capacity = newCapacity;
+    }
+
+    ExpenseTable(const ExpenseTable &);
+    ExpenseTable &operator=(const ExpenseTable &);
+};
+
+// ============================================================================
+// LAZY LEDGER SEGMENTS
+// ============================================================================
+//
+// An on-disk ledger is a manifest plus one tab-separated data file per month:
+//
+//   ledger.manifest   "# expense-ledger v1" then one line per segment:
+//                     key <TAB> file <TAB> rows <TAB> first-date <TAB> last-date
+//   2025-05.tsv       date <TAB> amount <TAB> category <TAB> description
+//
+// Only the manifest is read at startup. A segment's rows are read the first
+// time a query touches it, and the least recently used segments are dropped
+// again whenever the loaded rows exceed the memory cap.
+
+const char *const LEDGER_MANIFEST_HEADER = "# expense-ledger v1";
+const size_t DEFAULT_LEDGER_MEMORY_CAP_MB = 256; // Default for --memory-cap
+
+// Metadata for one month of an on-disk ledger
+struct LedgerSegment
+{
+    std::string key;          // Month in YYYY-MM format
+    std::string fileName;     // Data file, relative to the manifest's directory
+    int rowCount;        // Rows in the data file
+    int32_t firstDay;    // Earliest date in the segment (day number)
+    int32_t lastDay;     // Latest date in the segment (day number)
+    ExpenseTable *rows;  // Loaded rows, or NULL while the segment is cold
+    int pins;            // Queries currently reading the rows (blocks eviction)
+    unsigned long lastUsed; // Pin tick used to pick eviction victims
+};
+
+/**
+ * Removes characters that would break the tab-separated row format
+ */
+inline std::string sanitizeLedgerField(const std::string &value)
+{
+    std::string clean = value;
+    for (size_t i = 0; i < clean.size(); ++i)
+    {
+        if (clean[i] == '\t' || clean[i] == '\n' || clean[i] == '\r')
+            clean[i] = ' ';
+    }
+    return clean;
+}
+
+/**
+ * Appends one data-file line, newline included; tabs and line breaks in the
+ * category or description are written as spaces
+ */
+inline void appendLedgerRow(std::string &line, int32_t day, int32_t cents, const std::string &category,
+                            const char *description, size_t length)
+{
+    char date[11];
+    formatDayNumber(day, date);
+    char amount[16];
+    snprintf(amount, sizeof(amount), "%d.%02d", cents / 100, cents % 100);
+    line.append(date, 10).append(1, '\t').append(amount).append(1, '\t');
+    for (size_t i = 0; i < category.size(); ++i)
+    {
+        char c = category[i];
+        line.append(1, c == '\t' || c == '\n' || c == '\r' ? ' ' : c);
+    }
+    line.append(1, '\t');
+    for (size_t i = 0; i < length; ++i)
+    {
+        char c = description[i];
+        line.append(1, c == '\t' || c == '\n' || c == '\r' ? ' ' : c);
+    }
+    line.append(1, '\n');
+}
+
+/**
+ * Parses the amount, category and description of one data-file line; the
+ * leading date field is converted separately (see parseLedgerRow)
+ * @param cents Set to the row's amount in cents
+ * @return false if the line is malformed
+ */
+inline bool parseLedgerFields(const std::string &line, int32_t &cents, std::string &category, std::string &description)
+{
+    if (line.size() <= DATE_FIELD_LENGTH || line[DATE_FIELD_LENGTH] != '\t')
+        return false;
+    size_t second = line.find('\t', DATE_FIELD_LENGTH + 1);
+    size_t third = second == std::string::npos ? std::string::npos : line.find('\t', second + 1);
+    if (third == std::string::npos)
+        return false;
+
+    category.assign(line, second + 1, third - second - 1);
+    description.assign(line, third + 1, std::string::npos);
+    if (!description.empty() && description[description.size() - 1] == '\r')
+        description.erase(description.size() - 1);
+
+    // The amount must run exactly up to the next tab
+    const char *amount = line.c_str() + DATE_FIELD_LENGTH + 1;
+    char *end = NULL;
+    double value = strtod(amount, &end);
+    int64_t parsedCents = static_cast<int64_t>(llround(value * 100.0));
+    cents = static_cast<int32_t>(parsedCents);
+    return end != amount && end == line.c_str() + second && parsedCents > 0 && parsedCents <= MAX_AMOUNT_CENTS &&
+           !category.empty() && !description.empty();
+}
+
+/**
+ * Parses one data-file line
+ * @param day Set to the row's day number
+ * @param cents Set to the row's amount in cents
+ * @return false if the line is malformed
+ */
+inline bool parseLedgerRow(const std::string &line, int32_t &day, int32_t &cents, std::string &category, std::string &description)
+{
+    return line.size() > DATE_FIELD_LENGTH && parseDateField(line.data(), day) &&
+           parseLedgerFields(line, cents, category, description);
+}
+
+const size_t LEDGER_BATCH_ROWS = 256; // Data-file lines whose dates are converted together
+
+/**
+ * Reads data-file lines in blocks, converting each block's date fields with
+ * one parseDateFields() call before the rest of the rows are parsed
+ */
+class LedgerLineBatch
+{
+public:
+    LedgerLineBatch() : lines(LEDGER_BATCH_ROWS), count(0) {}
+
+    /**
+     * Reads up to LEDGER_BATCH_ROWS lines and converts their date fields
+     * @return false once the stream has no more lines
+     */
+    bool read(std::istream &in)
+    {
+        static const char NOT_A_DATE[] = "----------";
+        const char *fields[LEDGER_BATCH_ROWS];
+        count = 0;
+        while (count < LEDGER_BATCH_ROWS && std::getline(in, lines[count]))
+        {
+            // Lines without a date-sized first column get a field that never parses
+            const std::string &line = lines[count];
+            fields[count] = line.size() > DATE_FIELD_LENGTH && line[DATE_FIELD_LENGTH] == '\t' ? line.data() : NOT_A_DATE;
+            count++;
+        }
+        parseDateFields(fields, count, days, valid);
+        return count > 0;
+    }
+
+    size_t size() const { return count; }
+    const std::string &line(size_t i) const { return lines[i]; }
+
+    /**
+     * @param day Set to the day number of line i when its date is valid
+     * @return true if line i starts with a real calendar date and a tab
+     */
+    bool dateOf(size_t i, int32_t &day) const
+    {
+        if (!valid[i])
+            return false;
+        day = days[i];
+        return true;
+    }
+
+private:
+    std::vector<std::string> lines; // Reused so line buffers are allocated once
+    size_t count;                   // Lines in the current block
+    int32_t days[LEDGER_BATCH_ROWS];
+    uint8_t valid[LEDGER_BATCH_ROWS];
+};
+
+/**
+ * Parses a manifest date column ("-" for an empty segment)
+ */
+inline bool parseManifestDay(const std::string &text, int32_t &day)
+{
+    day = 0;
+    return text == "-" || parseDayNumber(text, day);
+}
+
+/**
+ * Registry of the segments of an on-disk ledger with on-demand loading
+ * Loading and eviction are guarded by an internal mutex so several readers
+ * may pin segments concurrently; appends must not overlap with readers.
+ */
+class SegmentStore
+{
+public:
+    /**
+     * @param manifestPath Path of the ledger manifest
+     * @param memoryCapBytes Loaded rows above this size trigger eviction
+     * @param categories Category table shared with the tracker
+     */
+    SegmentStore(const std::string &manifestPath, size_t memoryCapBytes, CategoryTable &categories)
+        : manifestPath(manifestPath), memoryCap(memoryCapBytes), loadedBytes(0), tick(0), dirty(false),
+          categories(categories), batching(false)
+    {
+        size_t slash = manifestPath.find_last_of("/\\");
+        directory = slash == std::string::npos ? "" : manifestPath.substr(0, slash + 1);
+    }
+
+    /**
+     * Destructor - writes pending metadata and frees loaded segments
+     */
+    ~SegmentStore()
+    {
+        std::string ignored; // Owners that need to see failures call saveManifest() first
+        endBatch(ignored);
+        saveManifest(ignored);
+        for (size_t i = 0; i < segments.size(); ++i)
+        {
+            delete segments[i]->rows;
+            delete segments[i];
+        }
+    }
+
+    /**
+     * Registers every segment listed in the manifest without reading any rows
+     * A missing manifest starts a new, empty ledger
+     * @param error Set to a user-facing message on failure
+     * @return false if the manifest exists but cannot be parsed
+     */
+    bool open(std::string &error)
+    {
+        std::ifstream manifest(manifestPath.c_str());
+        if (!manifest)
+        {
+            dirty = true; // Create the manifest on first save
+            return true;
+        }
+
+        std::string line;
+        int lineNumber = 0;
+        while (std::getline(manifest, line))
+        {
+            lineNumber++;
+            if (line.empty() || line[0] == '#')
+                continue;
+
+            std::istringstream fields(line);
+            LedgerSegment *segment = new LedgerSegment();
+            std::string firstDate, lastDate;
+            if (!std::getline(fields, segment->key, '\t') || !std::getline(fields, segment->fileName, '\t') ||
+                !(fields >> segment->rowCount) || !(fields >> firstDate) || !(fields >> lastDate) ||
+                !parseManifestDay(firstDate, segment->firstDay) || !parseManifestDay(lastDate, segment->lastDay))
+            {
+                delete segment;
+                std::ostringstream message;
+                message << "Error: Malformed ledger manifest at line " << lineNumber << ".";
+                error = message.str();
+                return false;
+            }
+            segment->rows = NULL;
+            segment->pins = 0;
+            segment->lastUsed = 0;
+            insertSorted(segment);
+        }
+        return true;
+    }
+
+    int getSegmentCount() const { return static_cast<int>(segments.size()); }
+    const LedgerSegment &getSegment(int index) const { return *segments[index]; }
+
+    /**
+     * @return Segment at a position in date order. The pointer stays valid for
+     * the store's lifetime; positions shift when an earlier month is created.
+     */
+    LedgerSegment *segmentAt(int index) { return segments[index]; }
+
+    /**
+     * @return Total rows across all segments, loaded or not
+     */
+    int getRowCount() const
+    {
+        int total = 0;
+        for (size_t i = 0; i < segments.size(); ++i)
+            total += segments[i]->rowCount;
+        return total;
+    }
+
+    /**
+     * @return true if the segment may contain days in [startDay, endDay]
+     */
+    bool overlaps(int index, int32_t startDay, int32_t endDay) const
+    {
+        const LedgerSegment &segment = *segments[index];
+        return segment.rowCount > 0 && segment.lastDay >= startDay && segment.firstDay <= endDay;
+    }
+
+    /**
+     * Loads the segment if needed and keeps it resident until unpin()
+     * @return The segment's rows, or NULL if its data file cannot be read
+     */
+    const ExpenseTable *pin(LedgerSegment *segment)
+    {
+        std::lock_guard<std::mutex> guard(storeMutex);
+        if (segment->rows == NULL && !load(*segment))
+            return NULL;
+        segment->pins++;
+        segment->lastUsed = ++tick;
+        evictOverCap();
+        return segment->rows;
+    }
+
+    void unpin(LedgerSegment *segment)
+    {
+        std::lock_guard<std::mutex> guard(storeMutex);
+        segment->pins--;
+        evictOverCap();
+    }
+
+    /**
+     * Appends an expense to its month's data file, creating the segment if new
+     * @param day Expense date as a day number
+     * @param cents Expense amount in cents
+     * @param categoryId ID of an already sanitized category name
+     * @param error Set to a user-facing message on failure
+     * @throws bad_alloc if memory cannot be allocated
+     */
+    bool append(int32_t day, int32_t cents, uint16_t categoryId, const std::string &description, std::string &error)
+    {
+        std::lock_guard<std::mutex> guard(storeMutex);
+        std::string date = dayNumberToDate(day);
+        LedgerSegment *segment = findOrCreate(date.substr(0, 7));
+
+        std::string cleanDescription = sanitizeLedgerField(description);
+
+        std::string line;
+        line.reserve(cleanDescription.size() + 64);
+        appendLedgerRow(line, day, cents, categories.getName(categoryId), cleanDescription.data(), cleanDescription.size());
+
+        // Batches keep each month's file open until endBatch()
+        bool written;
+        if (batching)
+        {
+            written = static_cast<bool>(batchFile(segment).write(line.data(), line.size()));
+        }
+        else
+        {
+            std::ofstream data((directory + segment->fileName).c_str(), std::ios::app);
+            written = static_cast<bool>(data.write(line.data(), line.size()));
+        }
+        if (!written)
+        {
+            error = "Error: Cannot write ledger file " + directory + segment->fileName + ".";
+            return false;
+        }
+
+        if (segment->rows != NULL)
+        {
+            size_t before = segment->rows->memoryBytes();
+            segment->rows->append(day, cents, categoryId, cleanDescription);
+            loadedBytes += segment->rows->memoryBytes() - before;
+        }
+        if (segment->rowCount == 0 || day < segment->firstDay)
+            segment->firstDay = day;
+        if (segment->rowCount == 0 || day > segment->lastDay)
+            segment->lastDay = day;
+        segment->rowCount++;
+        segment->lastUsed = ++tick;
+        dirty = true;
+
+        // New and growing months count against the cap like loaded ones
+        evictOverCap(segment);
+        return true;
+    }
+
+    /**
+     * Starts a bulk append: data files stay open until endBatch()
+     */
+    void beginBatch()
+    {
+        std::lock_guard<std::mutex> guard(storeMutex);
+        batching = true;
+    }
+
+    /**
+     * Closes the files opened during a batch
+     * @param error Set to a user-facing message if any write failed
+     * @return false if a data file could not be flushed
+     */
+    bool endBatch(std::string &error)
+    {
+        std::lock_guard<std::mutex> guard(storeMutex);
+        bool ok = true;
+        for (std::map<LedgerSegment *, std::ofstream *>::iterator it = openFiles.begin(); it != openFiles.end(); ++it)
+        {
+            it->second->close();
+            if (it->second->fail())
+            {
+                error = "Error: Cannot write ledger file " + directory + it->first->fileName + ".";
+                ok = false;
+            }
+            delete it->second;
+        }
+        openFiles.clear();
+        batching = false;
+        return ok;
+    }
+
+    /**
+     * Rewrites the manifest if any segment metadata changed
+     * @param error Set to a user-facing message on failure
+     * @return false if the manifest cannot be written
+     */
+    bool saveManifest(std::string &error)
+    {
+        std::lock_guard<std::mutex> guard(storeMutex);
+        if (!dirty)
+            return true;
+
+        // Write a temporary file first so a crash never leaves half a manifest
+        std::string temporaryPath = manifestPath + ".tmp";
+        {
+            std::ofstream manifest(temporaryPath.c_str());
+            manifest << LEDGER_MANIFEST_HEADER << '\n';
+            for (size_t i = 0; i < segments.size(); ++i)
+            {
+                const LedgerSegment &segment = *segments[i];
+                manifest << segment.key << '\t' << segment.fileName << '\t' << segment.rowCount << '\t'
+                         << (segment.rowCount > 0 ? dayNumberToDate(segment.firstDay) : "-") << '\t'
+                         << (segment.rowCount > 0 ? dayNumberToDate(segment.lastDay) : "-") << '\n';
+            }
+            if (!manifest)
+            {
+                error = "Error: Cannot write ledger manifest " + temporaryPath + ".";
+                return false;
+            }
+        }
+#ifdef _WIN32
+        remove(manifestPath.c_str()); // rename() does not replace files on Windows
+#endif
+        if (rename(temporaryPath.c_str(), manifestPath.c_str()) != 0)
+        {
+            error = "Error: Cannot replace ledger manifest " + manifestPath + ".";
+            return false;
+        }
+        dirty = false;
+        return true;
+    }
+
+    /**
+     * Moves the messages recorded while loading segments (unreadable files,
+     * skipped rows) to the end of messages
+     */
+    void takeWarnings(std::vector<std::string> &messages)
+    {
+        std::lock_guard<std::mutex> guard(storeMutex);
+        messages.insert(messages.end(), warnings.begin(), warnings.end());
+        warnings.clear();
+    }
+
+    /**
+     * Adds every loaded segment's storage to a memory report
+     */
+    void addToReport(MemoryReport &report) const
+    {
+        std::lock_guard<std::mutex> guard(storeMutex);
+        report.segmentCount += static_cast<int>(segments.size());
+        report.memoryCap = memoryCap;
+        for (size_t i = 0; i < segments.size(); ++i)
+        {
+            if (segments[i]->rows != NULL)
+            {
+                segments[i]->rows->addToReport(report);
+                report.loadedSegments++;
+            }
+        }
+    }
+
+private:
+    std::string manifestPath;
+    std::string directory;                 // Manifest directory, with trailing separator
+    std::vector<LedgerSegment *> segments; // Sorted by month
+    size_t memoryCap;
+    size_t loadedBytes;
+    unsigned long tick;
+    bool dirty;                       // Metadata changed since the last save
+    mutable std::mutex storeMutex;
+    CategoryTable &categories;        // Shared with the tracker
+    bool batching;                    // Inside beginBatch()/endBatch()
+    std::map<LedgerSegment *, std::ofstream *> openFiles; // Data files held open by a batch
+    std::vector<std::string> warnings; // Load problems not yet collected by takeWarnings()
+
+    std::ofstream &batchFile(LedgerSegment *segment)
+    {
+        std::map<LedgerSegment *, std::ofstream *>::iterator it = openFiles.find(segment);
+        if (it != openFiles.end())
+            return *it->second;
+        std::ofstream *file = new std::ofstream((directory + segment->fileName).c_str(), std::ios::app);
+        openFiles[segment] = file;
+        return *file;
+    }
+
+    void insertSorted(LedgerSegment *segment)
+    {
+        std::vector<LedgerSegment *>::iterator position = segments.begin();
+        while (position != segments.end() && (*position)->key < segment->key)
+            ++position;
+        segments.insert(position, segment);
+    }
+
+    LedgerSegment *findOrCreate(const std::string &key)
+    {
+        for (size_t i = 0; i < segments.size(); ++i)
+        {
+            if (segments[i]->key == key)
+                return segments[i];
+        }
+
+        LedgerSegment *segment = new LedgerSegment();
+        segment->key = key;
+        segment->fileName = key + ".tsv";
+        segment->rowCount = 0;
+        segment->rows = new ExpenseTable(categories); // A brand-new month starts loaded and empty
+        segment->pins = 0;
+        segment->lastUsed = ++tick;
+        loadedBytes += segment->rows->memoryBytes();
+        insertSorted(segment);
+        return segment;
+    }
+
+    /**
+     * Reads a segment's data file; metadata is refreshed from what was read
+     * Caller must hold storeMutex
+     */
+    bool load(LedgerSegment &segment)
+    {
+        std::string path = directory + segment.fileName;
+
+        // A batch may still hold this segment's newest rows in its stream buffer
+        std::map<LedgerSegment *, std::ofstream *>::iterator open = openFiles.find(&segment);
+        if (open != openFiles.end() && !open->second->flush())
+        {
+            warnings.push_back("Error: Cannot write ledger file " + path + ".");
+            return false;
+        }
+
+        std::ifstream data(path.c_str());
+        if (!data)
+        {
+            warnings.push_back("Error: Cannot read ledger segment " + path + ".");
+            return false;
+        }
+
+        ExpenseTable *rows = new ExpenseTable(categories);
+        LedgerLineBatch batch;
+        std::string category, description;
+        int32_t day, cents;
+        int skipped = 0;
+        while (batch.read(data))
+        {
+            for (size_t i = 0; i < batch.size(); ++i)
+            {
+                const std::string &line = batch.line(i);
+                if (line.empty())
+                    continue;
+                if (!batch.dateOf(i, day) || !parseLedgerFields(line, cents, category, description))
+                {
+                    skipped++;
+                    continue;
+                }
+                rows->append(day, cents, categories.intern(category), description);
+                if (rows->getSize() == 1 || day < segment.firstDay)
+                    segment.firstDay = day;
+                if (rows->getSize() == 1 || day > segment.lastDay)
+                    segment.lastDay = day;
+            }
+        }
+        if (skipped > 0)
+        {
+            std::ostringstream message;
+            message << "Warning: Skipped " << skipped << " malformed rows in " << path << ".";
+            warnings.push_back(message.str());
+        }
+        if (rows->getSize() != segment.rowCount)
+        {
+            segment.rowCount = rows->getSize();
+            dirty = true;
+        }
+
+        segment.rows = rows;
+        loadedBytes += rows->memoryBytes();
+        return true;
+    }
+
+    /**
+     * Drops least recently used unpinned segments until under the memory cap
+     * Caller must hold storeMutex
+     * @param keep Segment to leave loaded even if it is a candidate
+     */
+    void evictOverCap(const LedgerSegment *keep = NULL)
+    {
+        while (loadedBytes > memoryCap)
+        {
+            LedgerSegment *victim = NULL;
+            for (size_t i = 0; i < segments.size(); ++i)
+            {
+                LedgerSegment *segment = segments[i];
+                if (segment != keep && segment->rows != NULL && segment->pins == 0 &&
+                    (victim == NULL || segment->lastUsed < victim->lastUsed))
+                    victim = segment;
+            }
+            if (victim == NULL)
+                return; // Everything loaded is in use
+
+            loadedBytes -= victim->rows->memoryBytes();
+            delete victim->rows;
+            victim->rows = NULL;
+        }
+    }
+
+    SegmentStore(const SegmentStore &);
+    SegmentStore &operator=(const SegmentStore &);
+};
+
+/**
+ * Keeps a ledger segment pinned for the lifetime of the guard
+ */
+class SegmentPin
+{
+public:
+    SegmentPin(SegmentStore &store, LedgerSegment *segment) : store(store), segment(segment), rows(store.pin(segment)) {}
+    ~SegmentPin()
+    {
+        if (rows != NULL)
+            store.unpin(segment);
+    }
+    const ExpenseTable *get() const { return rows; }
+
+private:
+    SegmentStore &store;
+    LedgerSegment *segment;
+    const ExpenseTable *rows;
+    SegmentPin(const SegmentPin &);
+    SegmentPin &operator=(const SegmentPin &);
+};
+
+// ============================================================================
+// BUDGET AND THRESHOLD ALERTS
+// ============================================================================
+//
+// Rules file, one rule per line ('#' starts a comment, categories containing
+// spaces may be quoted):
+//
+//   single  CATEGORY|*  AMOUNT           any one expense above AMOUNT
+//   budget  CATEGORY|*  PERIOD  AMOUNT   spend per day|month|quarter|year above AMOUNT
+//
+// Running totals are kept per (period, category) rather than per rule, so an
+// insert updates one bucket per period kind in use and is then compared only
+// against the rules indexed under its category or '*'. A budget rule fires
+// once, on the insert that takes its total from at-or-below the limit to
+// above it. Rows stored after the rules are loaded reach every period through
+// onInsert. If rows were stored before that (a reopened ledger, say), a
+// period's totals are seeded from the tracker's date-range index the first
+// time an insert lands in it, so alerts stay correct across restarts and
+// seeding costs O(log) rather than a scan of the stored rows.
+
+enum AlertPeriod
+{
+    PERIOD_DAY,
+    PERIOD_MONTH,
+    PERIOD_QUARTER,
+    PERIOD_YEAR,
+    PERIOD_KINDS
+};
+
+const char *const PERIOD_NAMES[PERIOD_KINDS] = {"day", "month", "quarter", "year"};
+
+// One alert rule as read from the rules file
+struct AlertRule
+{
+    bool budget;         // true = period budget, false = single-expense threshold
+    int categoryId;      // Category the rule watches, or -1 for any category
+    std::string categoryName; // Category as written in the rules file ("*" for any)
+    AlertPeriod period;  // Budget period (budget rules only)
+    int64_t limitCents;  // Threshold in cents
+};
+
+// Spend within one period, per category ID and overall
+struct PeriodTotals
+{
+    std::vector<int64_t> byCategory; // Indexed by category ID
+    int64_t total;
+
+    PeriodTotals() : total(0) {}
+
+    void add(uint16_t categoryId, int64_t cents)
+    {
+        if (categoryId >= byCategory.size())
+            byCategory.resize(categoryId + 1, 0);
+        byCategory[categoryId] += cents;
+        total += cents;
+    }
+};
+
+/**
+ * Computes the period containing a day
+ * @param key Set to a number unique to the period within its kind
+ * @param startDay Set to the first day of the period
+ * @param endDay Set to the last day of the period
+ */
+inline void periodBounds(int32_t day, AlertPeriod period, int64_t &key, int32_t &startDay, int32_t &endDay)
+{
+    int year, month, dayOfMonth;
+    civilFromDays(day, year, month, dayOfMonth);
+    switch (period)
+    {
+    case PERIOD_DAY:
+        key = day;
+        startDay = endDay = day;
+        break;
+    case PERIOD_MONTH:
+        key = year * 12 + (month - 1);
+        startDay = daysFromCivil(year, month, 1);
+        endDay = (month == 12 ? daysFromCivil(year + 1, 1, 1) : daysFromCivil(year, month + 1, 1)) - 1;
+        break;
+    case PERIOD_QUARTER:
+    {
+        int firstMonth = (month - 1) / 3 * 3 + 1;
+        key = year * 4 + (month - 1) / 3;
+        startDay = daysFromCivil(year, firstMonth, 1);
+        endDay = (firstMonth == 10 ? daysFromCivil(year + 1, 1, 1) : daysFromCivil(year, firstMonth + 3, 1)) - 1;
+        break;
+    }
+    default:
+        key = year;
+        startDay = daysFromCivil(year, 1, 1);
+        endDay = daysFromCivil(year + 1, 1, 1) - 1;
+    }
+}
+
+/**
+ * @return Human-readable name of the period starting at startDay (e.g. "2025-Q2")
+ */
+inline std::string periodLabel(AlertPeriod period, int32_t startDay)
+{
+    std::string date = dayNumberToDate(startDay);
+    switch (period)
+    {
+    case PERIOD_DAY:
+        return date;
+    case PERIOD_MONTH:
+        return date.substr(0, 7);
+    case PERIOD_QUARTER:
+        return date.substr(0, 4) + "-Q" + static_cast<char>('1' + (atoi(date.substr(5, 2).c_str()) - 1) / 3);
+    default:
+        return date.substr(0, 4);
+    }
+}
+
+/**
+ * Reads one whitespace-separated token, allowing "double quoted" tokens
+ */
+inline bool readRuleToken(std::istringstream &fields, std::string &token)
+{
+    if (!(fields >> token))
+        return false;
+    if (token[0] != '"')
+        return true;
+
+    // Keep reading until the closing quote
+    while (token.size() < 2 || token[token.size() - 1] != '"')
+    {
+        std::string next;
+        if (!(fields >> next))
+            return false;
+        token += " " + next;
+    }
+    token = token.substr(1, token.size() - 2);
+    return true;
+}
+
+/**
+ * Evaluates budget and threshold rules as expenses are inserted
+ */
+class AlertEngine
+{
+public:
+    AlertEngine() : sink(NULL), alertCount(0)
+    {
+        for (int i = 0; i < PERIOD_KINDS; ++i)
+            periodInUse[i] = false;
+    }
+
+    /**
+     * Reads rules from a file, adding them to any already loaded
+     * @param categories Table used to resolve category names to IDs
+     * @param error Set to a user-facing message on failure
+     * @return false if the file cannot be read or contains a malformed rule
+     */
+    bool loadRules(const std::string &path, CategoryTable &categories, std::string &error)
+    {
+        std::ifstream file(path.c_str());
+        if (!file)
+        {
+            error = "Error: Cannot read alert rules file " + path + ".";
+            return false;
+        }
+
+        std::string line;
+        int lineNumber = 0;
+        while (std::getline(file, line))
+        {
+            lineNumber++;
+            size_t comment = line.find('#');
+            if (comment != std::string::npos)
+                line.erase(comment);
+
+            std::istringstream fields(line);
+            std::string kind, category, period, amount, extra;
+            if (!(fields >> kind))
+                continue; // Blank or comment-only line
+
+            AlertRule rule;
+            rule.budget = kind == "budget";
+            rule.period = PERIOD_MONTH;
+            bool valid = (kind == "single" || kind == "budget") && readRuleToken(fields, category);
+            if (valid && rule.budget)
+            {
+                valid = static_cast<bool>(fields >> period) && parsePeriod(period, rule.period);
+            }
+            valid = valid && static_cast<bool>(fields >> amount) && !(fields >> extra);
+
+            char *end = NULL;
+            double limit = valid ? strtod(amount.c_str(), &end) : 0.0;
+            if (!valid || end == amount.c_str() || *end != '\0' || limit < 0)
+            {
+                std::ostringstream message;
+                message << "Error: Malformed alert rule at " << path << " line " << lineNumber << ".";
+                error = message.str();
+                return false;
+            }
+
+            rule.limitCents = static_cast<int64_t>(llround(limit * 100.0));
+            rule.categoryName = category;
+            rule.categoryId = category == "*" ? -1 : categories.intern(category);
+            addRule(rule);
+        }
+        return true;
+    }
+
+    /**
+     * Sends alerts to a stream; until an output is set, alerts are only counted
+     */
+    void setOutputStream(std::ostream &out)
+    {
+        sink = &out;
+    }
+
+    /**
+     * Sends alerts to a file (appended to)
+     * @return false if the file cannot be opened
+     */
+    bool setOutputFile(const std::string &path, std::string &error)
+    {
+        outputFile.open(path.c_str(), std::ios::app);
+        if (!outputFile)
+        {
+            error = "Error: Cannot open alert output file " + path + ".";
+            return false;
+        }
+        sink = &outputFile;
+        return true;
+    }
+
+    bool empty() const { return rules.empty(); }
+    int getRuleCount() const { return static_cast<int>(rules.size()); }
+    long getAlertCount() const { return alertCount; }
+
+    /**
+     * @return true if a budget rule names this category (its period totals are read)
+     */
+    bool hasCategoryBudget(int categoryId) const
+    {
+        return static_cast<size_t>(categoryId) < budgetByCategory.size() && !budgetByCategory[categoryId].empty();
+    }
+
+    /**
+     * Updates running totals for a newly stored expense and fires any alerts
+     * @param expense The expense just stored
+     * @param seedPeriod Called as seedPeriod(startDay, endDay, PeriodTotals &)
+     *        to total rows already stored (including this one) the first time
+     *        a period is touched
+     */
+    template <typename SeedFn>
+    void onInsert(const ExpenseRef &expense, SeedFn seedPeriod)
+    {
+        // Single-expense thresholds need no running state
+        fireSingles(singleAny, expense);
+        if (expense.categoryId < singleByCategory.size())
+            fireSingles(singleByCategory[expense.categoryId], expense);
+
+        // Move each period bucket forward, remembering the totals before this row
+        int64_t categoryBefore[PERIOD_KINDS], totalBefore[PERIOD_KINDS];
+        int32_t periodStart[PERIOD_KINDS];
+        for (int kind = 0; kind < PERIOD_KINDS; ++kind)
+        {
+            if (!periodInUse[kind])
+                continue;
+
+            int64_t key;
+            int32_t startDay, endDay;
+            periodBounds(expense.day, static_cast<AlertPeriod>(kind), key, startDay, endDay);
+            periodStart[kind] = startDay;
+
+            std::unordered_map<int64_t, PeriodTotals>::iterator it = periods[kind].find(key);
+            if (it == periods[kind].end())
+            {
+                PeriodTotals &totals = periods[kind][key];
+                seedPeriod(startDay, endDay, totals); // Already includes this expense
+                totals.add(expense.categoryId, 0);
+                categoryBefore[kind] = totals.byCategory[expense.categoryId] - expense.cents;
+                totalBefore[kind] = totals.total - expense.cents;
+            }
+            else
+            {
+                PeriodTotals &totals = it->second;
+                totals.add(expense.categoryId, 0);
+                categoryBefore[kind] = totals.byCategory[expense.categoryId];
+                totalBefore[kind] = totals.total;
+                totals.add(expense.categoryId, expense.cents);
+            }
+        }
+
+        // Fire budget rules whose limit this expense crossed
+        fireBudgets(budgetAny, expense, totalBefore, periodStart);
+        if (expense.categoryId < budgetByCategory.size())
+            fireBudgets(budgetByCategory[expense.categoryId], expense, categoryBefore, periodStart);
+    }
+
+private:
+    std::vector<AlertRule> rules;
+    std::vector<int> singleAny;                   // Single-expense rules for any category
+    std::vector<std::vector<int> > singleByCategory;   // Indexed by category ID
+    std::vector<int> budgetAny;                   // Budget rules for any category
+    std::vector<std::vector<int> > budgetByCategory;   // Indexed by category ID
+    bool periodInUse[PERIOD_KINDS];          // Period kinds some budget rule uses
+    std::unordered_map<int64_t, PeriodTotals> periods[PERIOD_KINDS];
+    std::ostream *sink;          // Alert output, or NULL to only count alerts
+    std::ofstream outputFile;
+    long alertCount;
+
+    static bool parsePeriod(const std::string &name, AlertPeriod &period)
+    {
+        for (int i = 0; i < PERIOD_KINDS; ++i)
+        {
+            if (name == PERIOD_NAMES[i])
+            {
+                period = static_cast<AlertPeriod>(i);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void addRule(const AlertRule &rule)
+    {
+        int index = static_cast<int>(rules.size());
+        rules.push_back(rule);
+
+        std::vector<int> &any = rule.budget ? budgetAny : singleAny;
+        std::vector<std::vector<int> > &byCategory = rule.budget ? budgetByCategory : singleByCategory;
+        if (rule.categoryId < 0)
+        {
+            any.push_back(index);
+        }
+        else
+        {
+            if (static_cast<size_t>(rule.categoryId) >= byCategory.size())
+                byCategory.resize(rule.categoryId + 1);
+            byCategory[rule.categoryId].push_back(index);
+        }
+        if (rule.budget)
+            periodInUse[rule.period] = true;
+    }
+
+    void fireSingles(const std::vector<int> &matching, const ExpenseRef &expense)
+    {
+        for (size_t i = 0; i < matching.size(); ++i)
+        {
+            const AlertRule &rule = rules[matching[i]];
+            if (expense.cents > rule.limitCents)
+            {
+                alertCount++;
+                if (sink == NULL)
+                    continue;
+                *sink << "ALERT: Single expense over $" << formatCents(rule.limitCents)
+                      << (rule.categoryId < 0 ? "" : " in " + rule.categoryName) << ": ";
+                writeExpense(expense);
+                *sink << std::endl;
+            }
+        }
+    }
+
+    void fireBudgets(const std::vector<int> &matching, const ExpenseRef &expense,
+                     const int64_t before[], const int32_t periodStart[])
+    {
+        for (size_t i = 0; i < matching.size(); ++i)
+        {
+            const AlertRule &rule = rules[matching[i]];
+            int64_t after = before[rule.period] + expense.cents;
+            if (before[rule.period] <= rule.limitCents && after > rule.limitCents)
+            {
+                alertCount++;
+                if (sink == NULL)
+                    continue;
+                *sink << "ALERT: " << (rule.categoryId < 0 ? "Total" : rule.categoryName)
+                      << " spend for " << PERIOD_NAMES[rule.period] << " "
+                      << periodLabel(rule.period, periodStart[rule.period])
+                      << " is $" << formatCents(after) << ", over the $" << formatCents(rule.limitCents)
+                      << " budget (triggered by ";
+                writeExpense(expense);
+                *sink << ")" << std::endl;
+            }
+        }
+    }
+
+    void writeExpense(const ExpenseRef &expense)
+    {
+        char date[11];
+        formatDayNumber(expense.day, date);
+        *sink << date << " $" << formatCents(expense.cents) << " " << *expense.category << " - ";
+        sink->write(expense.description, expense.descriptionLength);
+    }
+
+    AlertEngine(const AlertEngine &);
+    AlertEngine &operator=(const AlertEngine &);
+};
+
+// ============================================================================
+// DUPLICATE DETECTION
+// ============================================================================
+//
+// Each expense is reduced to a 64-bit fingerprint of (date, amount,
+// category, normalized description), where the description is lowercased
+// and its whitespace runs collapsed. Fingerprints sit in an open-addressing
+// table with a Bloom filter in front, so rows that were never seen before
+// are usually rejected without touching the table.
+//
+// Each entry counts the rows stored before the current import and how many
+// of those the import has already matched. An import that contains two
+// identical coffees is therefore only skipped if the ledger already holds
+// two, not merely one. Only rows within the lookback window of the newest
+// date seen are tracked; older fingerprints are dropped when the table is
+// rebuilt.
+
+const int DEFAULT_DEDUP_WINDOW_DAYS = 120;  // Default for --dedup-window
+const size_t MAX_REPORTED_DUPLICATES = 20;  // Duplicates listed in an import report
+const int BLOOM_HASHES = 3;                 // Bits set per fingerprint
+const size_t MIN_DEDUP_CAPACITY = 1024;     // Smallest fingerprint table
+
+/**
+ * Hashes an expense's identifying fields; the description is normalized
+ * (ASCII lowercase, whitespace runs collapsed, trimmed) without copying it
+ * @return Non-zero fingerprint
+ */
+inline uint64_t expenseFingerprint(int32_t day, int32_t cents, uint16_t categoryId, const char *description, size_t length)
+{
+    const uint64_t prime = 1099511628211ull;
+    uint64_t hash = 14695981039346656037ull;
+    hash = (hash ^ static_cast<uint32_t>(day)) * prime;
+    hash = (hash ^ static_cast<uint32_t>(cents)) * prime;
+    hash = (hash ^ categoryId) * prime;
+
+    bool pendingSpace = false;
+    bool started = false;
+    for (size_t i = 0; i < length; ++i)
+    {
+        unsigned char c = static_cast<unsigned char>(description[i]);
+        if (isspace(c))
+        {
+            pendingSpace = started;
+            continue;
+        }
+        if (pendingSpace)
+        {
+            hash = (hash ^ ' ') * prime;
+            pendingSpace = false;
+        }
+        hash = (hash ^ static_cast<unsigned char>(tolower(c))) * prime;
+        started = true;
+    }
+
+    // Final avalanche (splitmix64) so every bit depends on every input byte
+    hash ^= hash >> 30;
+    hash *= 0xbf58476d1ce4e5b9ull;
+    hash ^= hash >> 27;
+    hash *= 0x94d049bb133111ebull;
+    hash ^= hash >> 31;
+    return hash == 0 ? 1 : hash;
+}
+
+// Outcome of one bulk import
+struct ImportReport
+{
+    long rowsRead;                 // Non-empty lines read
+    long imported;                 // Rows stored
+    long duplicates;               // Rows skipped as duplicates
+    long malformed;                // Rows that could not be parsed
+    std::vector<std::string> duplicateRows;  // "line N: <row>" for the first MAX_REPORTED_DUPLICATES duplicates
+};
+
+/**
+ * Fingerprint set used to skip re-imported expenses
+ */
+class DuplicateDetector
+{
+public:
+    DuplicateDetector()
+        : entries(NULL), capacity(0), count(0), bloom(NULL), bloomMask(0), windowDays(0),
+          newestDay(std::numeric_limits<int32_t>::min()), generation(1), enabled(false)
+    {
+    }
+
+    ~DuplicateDetector()
+    {
+        delete[] entries;
+        delete[] bloom;
+    }
+
+    /**
+     * Turns detection on
+     * @param lookbackDays Track rows this many days before the newest date seen (0 = all)
+     */
+    void enable(int lookbackDays)
+    {
+        windowDays = lookbackDays;
+        enabled = true;
+        if (entries == NULL)
+            rebuild(MIN_DEDUP_CAPACITY);
+    }
+
+    bool isEnabled() const { return enabled; }
+    size_t getTrackedCount() const { return count; }
+
+    /**
+     * Starts a new import; rows added by earlier imports now count as stored
+     */
+    void beginImport()
+    {
+        generation++;
+    }
+
+    /**
+     * Records a row stored outside an import (interactive or server add)
+     */
+    void recordStored(uint64_t fingerprint, int32_t day)
+    {
+        if (!track(day))
+            return;
+        Entry &entry = findOrInsert(fingerprint, day);
+        if (entry.stored < 0xFFFF)
+            entry.stored++;
+    }
+
+    /**
+     * Checks an imported row against the rows stored before this import
+     * A row that is not a duplicate is counted as added by this import
+     * @return true if the row duplicates a stored row and should be skipped
+     */
+    bool checkImported(uint64_t fingerprint, int32_t day)
+    {
+        if (!track(day))
+            return false; // Older than the lookback window: not checked
+
+        Entry &entry = findOrInsert(fingerprint, day);
+        if (entry.consumed < entry.stored)
+        {
+            entry.consumed++;
+            return true;
+        }
+        if (entry.added < 0xFFFF)
+            entry.added++;
+        return false;
+    }
+
+private:
+    struct Entry
+    {
+        uint64_t fingerprint; // 0 marks an empty slot
+        int32_t day;          // Expense date, used to expire the entry
+        uint32_t generation;  // Import that last touched the counters below
+        uint16_t stored;      // Rows stored before that import
+        uint16_t added;       // Rows that import added
+        uint16_t consumed;    // Stored rows that import matched as duplicates
+    };
+
+    Entry *entries;
+    size_t capacity; // Always a power of two
+    size_t count;
+    uint64_t *bloom;
+    uint64_t bloomMask; // Number of Bloom bits minus one
+    int windowDays;
+    int32_t newestDay;
+    uint32_t generation;
+    bool enabled;
+
+    /**
+     * Advances the window for a row's date
+     * @return false if the row is older than the window
+     */
+    bool track(int32_t day)
+    {
+        if (day > newestDay)
+            newestDay = day;
+        return windowDays <= 0 || day >= newestDay - windowDays;
+    }
+
+    bool bloomMayContain(uint64_t fingerprint) const
+    {
+        uint64_t step = (fingerprint >> 32) | 1;
+        for (int i = 0; i < BLOOM_HASHES; ++i)
+        {
+            uint64_t bit = (fingerprint + i * step) & bloomMask;
+            if ((bloom[bit >> 6] & (1ull << (bit & 63))) == 0)
+                return false;
+        }
+        return true;
+    }
+
+    void bloomAdd(uint64_t fingerprint)
+    {
+        uint64_t step = (fingerprint >> 32) | 1;
+        for (int i = 0; i < BLOOM_HASHES; ++i)
+        {
+            uint64_t bit = (fingerprint + i * step) & bloomMask;
+            bloom[bit >> 6] |= 1ull << (bit & 63);
+        }
+    }
+
+    Entry &findOrInsert(uint64_t fingerprint, int32_t day)
+    {
+        size_t mask = capacity - 1;
+        size_t slot = static_cast<size_t>(fingerprint) & mask;
+
+        // The Bloom filter answers "never seen" without probing the table
+        if (bloomMayContain(fingerprint))
+        {
+            while (entries[slot].fingerprint != 0)
+            {
+                if (entries[slot].fingerprint == fingerprint)
+                    return refresh(entries[slot]);
+                slot = (slot + 1) & mask;
+            }
+        }
+        else
+        {
+            while (entries[slot].fingerprint != 0)
+                slot = (slot + 1) & mask;
+        }
+
+        if ((count + 1) * 2 > capacity)
+        {
+            rebuild(capacity);
+            return findOrInsert(fingerprint, day);
+        }
+
+        Entry &entry = entries[slot];
+        entry.fingerprint = fingerprint;
+        entry.day = day;
+        entry.generation = generation;
+        entry.stored = entry.added = entry.consumed = 0;
+        bloomAdd(fingerprint);
+        count++;
+        return entry;
+    }
+
+    /**
+     * Folds counters from an earlier import into the stored count
+     */
+    Entry &refresh(Entry &entry)
+    {
+        if (entry.generation != generation)
+        {
+            unsigned stored = static_cast<unsigned>(entry.stored) + entry.added;
+            entry.stored = static_cast<uint16_t>(stored > 0xFFFF ? 0xFFFF : stored);
+            entry.added = entry.consumed = 0;
+            entry.generation = generation;
+        }
+        return entry;
+    }
+
+    /**
+     * Rehashes live entries, dropping those that fell out of the window
+     * @param minimumCapacity Capacity to keep if the live entries still fit
+     */
+    void rebuild(size_t minimumCapacity)
+    {
+        size_t live = 0;
+        for (size_t i = 0; i < capacity; ++i)
+        {
+            if (entries[i].fingerprint != 0 && track(entries[i].day))
+                live++;
+        }
+
+        // Grow only if expiry did not free enough room (keep load under 1/4 after rebuild)
+        size_t newCapacity = minimumCapacity < MIN_DEDUP_CAPACITY ? MIN_DEDUP_CAPACITY : minimumCapacity;
+        while (live * 4 > newCapacity)
+            newCapacity *= 2;
+
+        Entry *newEntries = new Entry[newCapacity];
+        memset(newEntries, 0, newCapacity * sizeof(Entry));
+        size_t bloomWords = newCapacity / 4; // 16 Bloom bits per slot
+        uint64_t *newBloom = new uint64_t[bloomWords];
+        memset(newBloom, 0, bloomWords * sizeof(uint64_t));
+
+        Entry *oldEntries = entries;
+        size_t oldCapacity = capacity;
+        delete[] bloom;
+        entries = newEntries;
+        capacity = newCapacity;
+        bloom = newBloom;
+        bloomMask = bloomWords * 64 - 1;
+        count = 0;
+
+        for (size_t i = 0; i < oldCapacity; ++i)
+        {
+            const Entry &old = oldEntries[i];
+            if (old.fingerprint == 0 || !track(old.day))
+                continue;
+            size_t slot = static_cast<size_t>(old.fingerprint) & (capacity - 1);
+            while (entries[slot].fingerprint != 0)
+                slot = (slot + 1) & (capacity - 1);
+            entries[slot] = old;
+            bloomAdd(old.fingerprint);
+            count++;
+        }
+        delete[] oldEntries;
+    }
+
+    DuplicateDetector(const DuplicateDetector &);
+    DuplicateDetector &operator=(const DuplicateDetector &);
+};
+
+// ============================================================================
+// QUERY RESULTS
+// ============================================================================
+//
+// A query returns an ExpenseSelection: a span of row IDs, resolved to
+// ExpenseRef views only when read. Building one copies 8 bytes per matching
+// row and never copies a string. The selection pins every ledger segment it
+// points into, so its rows stay loaded until it is destroyed. To stream a
+// full history through a small memory cap, use ExpenseTracker::forEachExpense
+// instead.
+
+// Identifies one stored row: the table holding it (0 = in-memory rows,
+// s + 1 = the selection's copy of the s-th ledger segment at query time)
+// and its index in that table
+struct RowId
+{
+    uint32_t table;
+    uint32_t row;
+};
+
+// Count and sum over a set of expenses
+struct ExpenseTotals
+{
+    long count;         // Number of expenses
+    int64_t totalCents; // Sum of their amounts, in cents
+};
+
+/**
+ * Row-ID span returned by ExpenseTracker queries
+ * Row IDs resolve through the selection's own table list, so they stay valid
+ * for the selection's lifetime even if later inserts add ledger months. An
+ * ExpenseRef read from the selection borrows the table's strings and is
+ * valid until the next insert.
+ */
+class ExpenseSelection
+{
+public:
+    /**
+     * Forward iterator yielding an ExpenseRef per selected row
+     */
+    class const_iterator
+    {
+    public:
+        typedef std::forward_iterator_tag iterator_category;
+        typedef ExpenseRef value_type;
+        typedef ptrdiff_t difference_type;
+        typedef const ExpenseRef *pointer;
+        typedef ExpenseRef reference;
+
+        const_iterator() : selection(NULL), index(0) {}
+        const_iterator(const ExpenseSelection *selection, size_t index) : selection(selection), index(index) {}
+
+        ExpenseRef operator*() const { return (*selection)[index]; }
+        const_iterator &operator++()
+        {
+            ++index;
+            return *this;
+        }
+        const_iterator operator++(int)
+        {
+            const_iterator previous = *this;
+            ++index;
+            return previous;
+        }
+        bool operator==(const const_iterator &other) const { return index == other.index; }
+        bool operator!=(const const_iterator &other) const { return index != other.index; }
+
+    private:
+        const ExpenseSelection *selection;
+        size_t index;
+    };
+
+    ExpenseSelection() : ledger(NULL) {}
+
+    ExpenseSelection(ExpenseSelection &&other)
+        : ids(std::move(other.ids)), tables(std::move(other.tables)),
+          pinnedSegments(std::move(other.pinnedSegments)), ledger(other.ledger)
+    {
+        other.ledger = NULL;
+        other.pinnedSegments.clear();
+    }
+
+    ExpenseSelection &operator=(ExpenseSelection &&other)
+    {
+        if (this != &other)
+        {
+            release();
+            ids = std::move(other.ids);
+            tables = std::move(other.tables);
+            pinnedSegments = std::move(other.pinnedSegments);
+            ledger = other.ledger;
+            other.ledger = NULL;
+            other.pinnedSegments.clear();
+        }
+        return *this;
+    }
+
+    ~ExpenseSelection()
+    {
+        release();
+    }
+
+    size_t size() const { return ids.size(); }
+    bool empty() const { return ids.empty(); }
+
+    /**
+     * @return Start of the row-ID span (size() entries)
+     */
+    const RowId *rowIds() const { return ids.empty() ? NULL : &ids[0]; }
+
+    /**
+     * Resolves the i-th selected row
+     */
+    ExpenseRef operator[](size_t i) const
+    {
+        const RowId &id = ids[i];
+        return tables[id.table]->at(static_cast<int>(id.row));
+    }
+
+    const_iterator begin() const { return const_iterator(this, 0); }
+    const_iterator end() const { return const_iterator(this, ids.size()); }
+
+    /**
+     * @return Count and sum of the selected expenses
+     */
+    ExpenseTotals totals() const
+    {
+        ExpenseTotals result;
+        result.count = static_cast<long>(ids.size());
+        result.totalCents = 0;
+        for (size_t i = 0; i < ids.size(); ++i)
+        {
+            result.totalCents += (*this)[i].cents;
+        }
+        return result;
+    }
+
+private:
+    friend class ExpenseTracker;
+
+    std::vector<RowId> ids;
+    std::vector<const ExpenseTable *> tables; // Indexed by RowId::table
+    std::vector<LedgerSegment *> pinnedSegments; // Ledger segments to unpin on release
+    SegmentStore *ledger;
+
+    void release()
+    {
+        for (size_t i = 0; i < pinnedSegments.size(); ++i)
+        {
+            ledger->unpin(pinnedSegments[i]);
+        }
+        pinnedSegments.clear();
+    }
+
+    ExpenseSelection(const ExpenseSelection &);
+    ExpenseSelection &operator=(const ExpenseSelection &);
+};
+
+// ============================================================================
+// DATE-RANGE TOTALS INDEX
+// ============================================================================
+//
+// "How much between date A and date B" is answered from one index for all
+// expenses and one per category (created the first time a category is
+// used). Day numbers are grouped into aligned blocks of 32 days, and only
+// blocks that hold expenses are stored. Each block keeps a Fenwick tree of
+// counts and sums in cents over its days, and a second Fenwick tree sums
+// whole blocks in date order. A range total is two prefix sums, each a walk
+// over the earlier blocks plus one within a block: O(log blocks) however
+// many rows the range covers. Memory grows with the blocks in use, not with
+// the span between the earliest and latest dates, so a stray year-0025 row
+// costs one block. Inserts may arrive in any date order; the first row of a
+// new block rebuilds the block tree in linear time.
+
+const int DAY_BLOCK_SHIFT = 5;                      // log2 of the days per block
+const int DAYS_PER_BLOCK = 1 << DAY_BLOCK_SHIFT;    // Days covered by one block
+const int BLOCK_SLOTS = DAYS_PER_BLOCK + 1;         // Block total, then a 1-based day tree
+
+/**
+ * Date-range totals stored in 32-day blocks that have expenses
+ */
+class DayBlockTotals
+{
+public:
+    DayBlockTotals() : lastBlock(0) {}
+
+    /**
+     * Adds one expense on a day, creating its block if needed
+     * @throws bad_alloc if memory cannot be allocated
+     */
+    void add(int32_t day, int32_t cents)
+    {
+        int32_t key = day >> DAY_BLOCK_SHIFT;
+        size_t block = lastBlock; // Consecutive rows usually share a block
+        if (block >= keys.size() || keys[block] != key)
+        {
+            block = std::lower_bound(keys.begin(), keys.end(), key) - keys.begin();
+            if (block == keys.size() || keys[block] != key)
+                insertBlock(block, key);
+            lastBlock = block;
+        }
+
+        ExpenseTotals *slots = &blockSlots[block * BLOCK_SLOTS];
+        slots[0].count++;
+        slots[0].totalCents += cents;
+        for (int i = (day & (DAYS_PER_BLOCK - 1)) + 1; i <= DAYS_PER_BLOCK; i += i & -i)
+        {
+            slots[i].count++;
+            slots[i].totalCents += cents;
+        }
+        for (size_t i = block + 1; i < tree.size(); i += i & (~i + 1))
+        {
+            tree[i].count++;
+            tree[i].totalCents += cents;
+        }
+    }
+
+    /**
+     * @return Count and sum of the expenses dated in [startDay, endDay]
+     */
+    ExpenseTotals range(int32_t startDay, int32_t endDay) const
+    {
+        ExpenseTotals result = {0, 0};
+        if (keys.empty() || startDay > endDay)
+            return result;
+        ExpenseTotals upper = prefix(endDay);
+        ExpenseTotals lower = prefix(static_cast<int64_t>(startDay) - 1);
+        result.count = upper.count - lower.count;
+        result.totalCents = upper.totalCents - lower.totalCents;
+        return result;
+    }
+
+    size_t memoryBytes() const
+    {
+        return keys.capacity() * sizeof(int32_t) + (blockSlots.capacity() + tree.capacity()) * sizeof(ExpenseTotals);
+    }
+
+private:
+    std::vector<int32_t> keys;             // Block keys (day >> DAY_BLOCK_SHIFT) in ascending order
+    std::vector<ExpenseTotals> blockSlots; // BLOCK_SLOTS per block, in key order
+    std::vector<ExpenseTotals> tree;       // 1-based Fenwick tree of whole-block totals
+    size_t lastBlock;                      // Block of the previous insert
+
+    /**
+     * @return Totals for every expense dated on or before day
+     */
+    ExpenseTotals prefix(int64_t day) const
+    {
+        ExpenseTotals result = {0, 0};
+        int64_t key = day >> DAY_BLOCK_SHIFT;
+        size_t blocks = std::lower_bound(keys.begin(), keys.end(), key) - keys.begin();
+        if (blocks < keys.size() && keys[blocks] == key)
+        {
+            const ExpenseTotals *slots = &blockSlots[blocks * BLOCK_SLOTS];
+            for (int i = static_cast<int>(day & (DAYS_PER_BLOCK - 1)) + 1; i > 0; i -= i & -i)
+            {
+                result.count += slots[i].count;
+                result.totalCents += slots[i].totalCents;
+            }
+        }
+        for (size_t i = blocks; i > 0; i -= i & (~i + 1))
+        {
+            result.count += tree[i].count;
+            result.totalCents += tree[i].totalCents;
+        }
+        return result;
+    }
+
+    /**
+     * Inserts an empty block and rebuilds the block tree in O(blocks)
+     */
+    void insertBlock(size_t block, int32_t key)
+    {
+        ExpenseTotals none = {0, 0};
+        keys.insert(keys.begin() + block, key);
+        blockSlots.insert(blockSlots.begin() + block * BLOCK_SLOTS, BLOCK_SLOTS, none);
+
+        tree.assign(keys.size() + 1, none);
+        for (size_t i = 1; i < tree.size(); ++i)
+        {
+            const ExpenseTotals &total = blockSlots[(i - 1) * BLOCK_SLOTS];
+            tree[i].count += total.count;
+            tree[i].totalCents += total.totalCents;
+            size_t parent = i + (i & (~i + 1));
+            if (parent < tree.size())
+            {
+                tree[parent].count += tree[i].count;
+                tree[parent].totalCents += tree[i].totalCents;
+            }
+        }
+    }
+};
+
+/**
+ * Date-range totals overall and per category ID
+ */
+class RangeTotalsIndex
+{
+public:
+    /**
+     * Records one stored expense
+     * @throws bad_alloc if memory cannot be allocated
+     */
+    void add(int32_t day, int32_t cents, uint16_t categoryId)
+    {
+        if (categoryId >= byCategory.size())
+            byCategory.resize(categoryId + 1);
+        byCategory[categoryId].add(day, cents);
+        overall.add(day, cents);
+    }
+
+    /**
+     * @param categoryId Category to total, or -1 for all categories
+     * @return Count and sum of the matching expenses dated in [startDay, endDay]
+     */
+    ExpenseTotals range(int32_t startDay, int32_t endDay, int categoryId) const
+    {
+        if (categoryId < 0)
+            return overall.range(startDay, endDay);
+        if (static_cast<size_t>(categoryId) >= byCategory.size())
+        {
+            ExpenseTotals none = {0, 0};
+            return none;
+        }
+        return byCategory[categoryId].range(startDay, endDay);
+    }
+
+    size_t memoryBytes() const
+    {
+        size_t bytes = overall.memoryBytes() + byCategory.capacity() * sizeof(DayBlockTotals);
+        for (size_t i = 0; i < byCategory.size(); ++i)
+        {
+            bytes += byCategory[i].memoryBytes();
+        }
+        return bytes;
+    }
+
+private:
+    DayBlockTotals overall;
+    std::vector<DayBlockTotals> byCategory; // Indexed by category ID; empty until used
+};
+
+// ============================================================================
+// SORTED REPORTS
+// ============================================================================
+//
+// Reports can be ordered by date, amount or category name, ascending or
+// descending. Ties keep the order in which the rows were visited.
+//
+// ExpenseTracker::sortSelection reorders the row IDs of a selection in place
+// with a parallel in-memory sort. ExpenseTracker::forEachSorted streams rows
+// from any date range or category through an ExpenseSorter instead, so its
+// input never needs to fit in memory:
+//
+//   1. Rows are buffered until they fill half the memory budget (so the
+//      buffer's doubling growth stays under the budget), sorted, and spilled
+//      to a run file in the spill directory.
+//   2. If more than MAX_MERGE_FANIN runs exist, groups of them are merged
+//      into longer runs first.
+//   3. The remaining runs are merged with a heap and handed one row at a
+//      time to the caller's report writer.
+//
+// Selections that fit in the budget never touch the disk.
+
+enum SortKey
+{
+    SORT_BY_DATE,
+    SORT_BY_AMOUNT,
+    SORT_BY_CATEGORY,
+    SORT_KEYS
+};
+
+const char *const SORT_KEY_NAMES[SORT_KEYS] = {"date", "amount", "category"};
+
+const size_t DEFAULT_SORT_MEMORY_MB = 64;        // Default sort memory budget
+const size_t PARALLEL_SORT_MIN_ROWS = 1 << 16;   // Smaller sorts stay on one thread
+const unsigned MAX_SORT_THREADS = 8;             // Chunks sorted concurrently
+const size_t MAX_MERGE_FANIN = 64;               // Runs merged at once
+const size_t MAX_RUN_BUFFER_BYTES = 1024 * 1024; // Stream buffer per open run
+
+// How a report is ordered and how much memory sorting it may use
+struct SortOptions
+{
+    SortKey key;
+    bool descending;
+    size_t memoryBudget;        // Bytes of rows buffered before spilling a run
+    std::string spillDirectory; // Where run files are written
+
+    SortOptions()
+        : key(SORT_BY_DATE), descending(false), memoryBudget(DEFAULT_SORT_MEMORY_MB * 1024 * 1024),
+          spillDirectory(".")
+    {
+    }
+};
+
+/**
+ * Parses a sort key name ("date", "amount" or "category")
+ * @return false if the name is unknown
+ */
+inline bool parseSortKey(const std::string &name, SortKey &key)
+{
+    for (int i = 0; i < SORT_KEYS; ++i)
+    {
+        if (name == SORT_KEY_NAMES[i])
+        {
+            key = static_cast<SortKey>(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Sorts with std::sort, splitting large inputs into chunks sorted on
+ * separate threads and merged pairwise
+ * @param less Strict weak ordering
+ */
+template <typename T, typename Less>
+void parallelSort(std::vector<T> &values, Less less)
+{
+    unsigned threads = std::thread::hardware_concurrency();
+    if (threads > MAX_SORT_THREADS)
+        threads = MAX_SORT_THREADS;
+    if (values.size() < PARALLEL_SORT_MIN_ROWS || threads < 2)
+    {
+        std::sort(values.begin(), values.end(), less);
+        return;
+    }
+
+    // Chunk boundaries; chunk i is [bounds[i], bounds[i + 1])
+    std::vector<size_t> bounds;
+    for (unsigned i = 0; i <= threads; ++i)
+    {
+        bounds.push_back(values.size() * i / threads);
+    }
+
+    std::vector<std::thread> workers;
+    for (unsigned i = 0; i < threads; ++i)
+    {
+        workers.push_back(std::thread([&values, &bounds, less, i]()
+        {
+            std::sort(values.begin() + bounds[i], values.begin() + bounds[i + 1], less);
+        }));
+    }
+    for (size_t i = 0; i < workers.size(); ++i)
+    {
+        workers[i].join();
+    }
+
+    // Merge neighbouring chunks until one remains, each round's merges in parallel
+    while (bounds.size() > 2)
+    {
+        std::vector<size_t> merged;
+        workers.clear();
+        for (size_t i = 0; i + 1 < bounds.size(); i += 2)
+        {
+            merged.push_back(bounds[i]);
+            if (i + 2 < bounds.size())
+            {
+                size_t first = bounds[i], middle = bounds[i + 1], last = bounds[i + 2];
+                workers.push_back(std::thread([&values, less, first, middle, last]()
+                {
+                    std::inplace_merge(values.begin() + first, values.begin() + middle, values.begin() + last, less);
+                }));
+            }
+        }
+        merged.push_back(bounds.back());
+        for (size_t i = 0; i < workers.size(); ++i)
+        {
+            workers[i].join();
+        }
+        bounds.swap(merged);
+    }
+}
+
+/**
+ * @return The integer sort key of a row (0 for category sorts, which compare
+ *         names); descending orders negate it so keys always sort ascending
+ */
+inline int64_t sortKeyOf(const ExpenseRef &row, SortKey key, bool descending)
+{
+    int64_t value = 0;
+    if (key == SORT_BY_AMOUNT)
+        value = row.cents;
+    else if (key == SORT_BY_DATE)
+        value = row.day;
+    return descending ? -value : value;
+}
+
+// One buffered row during an external sort; also the on-disk record header,
+// followed in run files by descriptionLength bytes of description
+struct SortRecord
+{
+    int64_t key;                // From sortKeyOf()
+    uint64_t sequence;          // Visit order, breaks ties
+    int32_t day;
+    int32_t cents;
+    uint32_t descriptionOffset; // Into the in-memory description buffer (unused on disk)
+    uint16_t descriptionLength;
+    uint16_t categoryId;
+};
+
+// Orders sort records by category name (category sorts only), key, then
+// visit order. Names are compared rather than ranked up front because a lazy
+// ledger interns categories as its segments load, partway through a sort.
+struct SortRecordOrder
+{
+    const CategoryTable *categories; // NULL unless sorting by category
+    bool descending;
+
+    bool operator()(const SortRecord &a, const SortRecord &b) const
+    {
+        if (categories != NULL && a.categoryId != b.categoryId)
+        {
+            int order = categories->getName(a.categoryId).compare(categories->getName(b.categoryId));
+            return descending ? order > 0 : order < 0;
+        }
+        if (a.key != b.key)
+            return a.key < b.key;
+        return a.sequence < b.sequence;
+    }
+};
+
+/**
+ * External merge sort of expense rows under a memory budget
+ * add() every row, then finish() once to receive them in order
+ */
+class ExpenseSorter
+{
+public:
+    ExpenseSorter(const CategoryTable &categories, const SortOptions &options)
+        : categories(categories), options(options), nextSequence(0), runCounter(0)
+    {
+        order.categories = options.key == SORT_BY_CATEGORY ? &categories : NULL;
+        order.descending = options.descending;
+    }
+
+    ~ExpenseSorter()
+    {
+        for (size_t i = 0; i < runs.size(); ++i)
+        {
+            std::remove(runs[i].c_str());
+        }
+    }
+
+    /**
+     * Buffers one row, spilling a sorted run when the buffer is full
+     * The row's strings are copied, so it may come from an unpinned segment
+     * @param error Set to a user-facing message on failure
+     * @return false if a run could not be written
+     */
+    bool add(const ExpenseRef &row, std::string &error)
+    {
+        SortRecord record;
+        record.key = sortKeyOf(row, options.key, options.descending);
+        record.sequence = nextSequence++;
+        record.day = row.day;
+        record.cents = row.cents;
+        record.descriptionOffset = static_cast<uint32_t>(descriptions.size());
+        record.descriptionLength = row.descriptionLength;
+        record.categoryId = row.categoryId;
+        records.push_back(record);
+        descriptions.insert(descriptions.end(), row.description, row.description + row.descriptionLength);
+
+        size_t buffered = records.size() * sizeof(SortRecord) + descriptions.size();
+        if (buffered * 2 >= options.memoryBudget || descriptions.size() > 0xFFFF0000u)
+            return spill(error);
+        return true;
+    }
+
+    /**
+     * Delivers every added row in sort order to fn(const ExpenseRef &)
+     * The ExpenseRef passed to fn is only valid during the call
+     * @param error Set to a user-facing message on failure
+     * @return false if a run could not be written or read back
+     */
+    template <typename Fn>
+    bool finish(Fn fn, std::string &error)
+    {
+        // Everything fit in memory: sort and emit without touching the disk
+        if (runs.empty())
+        {
+            parallelSort(records, order);
+            for (size_t i = 0; i < records.size(); ++i)
+            {
+                fn(toRef(records[i], descriptions.data() + records[i].descriptionOffset));
+            }
+            return true;
+        }
+
+        if (!records.empty() && !spill(error))
+            return false;
+
+        // Merge groups of runs until one heap merge can take them all
+        while (runs.size() > MAX_MERGE_FANIN)
+        {
+            std::string merged = nextRunPath();
+            std::ofstream out(merged.c_str(), std::ios::binary);
+            std::vector<std::string> group(runs.begin(), runs.begin() + MAX_MERGE_FANIN);
+            bool ok = static_cast<bool>(out) && mergeRuns(group, [&out](const SortRecord &record, const char *description)
+            {
+                out.write(reinterpret_cast<const char *>(&record), sizeof(record));
+                out.write(description, record.descriptionLength);
+            }, error);
+            out.close();
+            for (size_t i = 0; i < group.size(); ++i)
+            {
+                std::remove(group[i].c_str());
+            }
+            runs.erase(runs.begin(), runs.begin() + MAX_MERGE_FANIN);
+            runs.push_back(merged);
+            if (!ok || out.fail())
+            {
+                if (error.empty())
+                    error = "Error: Cannot write sort run " + merged + ".";
+                return false;
+            }
+        }
+
+        return mergeRuns(runs, [&](const SortRecord &record, const char *description)
+        {
+            fn(toRef(record, description));
+        }, error);
+    }
+
+    /**
+     * @return Number of runs spilled to disk so far
+     */
+    size_t getSpilledRunCount() const { return runCounter; }
+
+private:
+    // A run file being read during a merge
+    struct RunReader
+    {
+        std::string path;
+        std::ifstream file;
+        std::vector<char> buffer;
+        SortRecord record;
+        std::string description;
+        bool failed; // Read error or truncated record (not a clean end of run)
+
+        RunReader() : failed(false) {}
+
+        /**
+         * Reads the next record
+         * @return false at the end of the run, or on failure (see failed)
+         */
+        bool next()
+        {
+            if (!file.read(reinterpret_cast<char *>(&record), sizeof(record)))
+            {
+                // Only end of file exactly between records ends a run cleanly
+                failed = file.bad() || file.gcount() != 0;
+                return false;
+            }
+            description.resize(record.descriptionLength);
+            if (record.descriptionLength > 0 && !file.read(&description[0], record.descriptionLength))
+            {
+                failed = true;
+                return false;
+            }
+            return true;
+        }
+    };
+
+    // Orders reader indices so the heap's top is the smallest current record
+    struct ReaderAfter
+    {
+        const std::vector<RunReader *> *readers;
+        SortRecordOrder order;
+        bool operator()(size_t a, size_t b) const { return order((*readers)[b]->record, (*readers)[a]->record); }
+    };
+
+    const CategoryTable &categories;
+    SortOptions options;
+    SortRecordOrder order;
+    std::vector<SortRecord> records;
+    std::vector<char> descriptions;
+    std::vector<std::string> runs; // Run files not yet merged away
+    uint64_t nextSequence;
+    size_t runCounter;
+
+    ExpenseRef toRef(const SortRecord &record, const char *description) const
+    {
+        ExpenseRef ref;
+        ref.day = record.day;
+        ref.cents = record.cents;
+        ref.categoryId = record.categoryId;
+        ref.category = &categories.getName(record.categoryId);
+        ref.description = description;
+        ref.descriptionLength = record.descriptionLength;
+        return ref;
+    }
+
+    std::string nextRunPath()
+    {
+        std::ostringstream path;
+#ifdef _WIN32
+        long processId = _getpid();
+#else
+        long processId = static_cast<long>(getpid());
+#endif
+        // The process ID keeps sorts in different processes sharing a spill
+        // directory apart; the sorter's address, sorts within this process
+        path << options.spillDirectory << "/expense-sort-" << processId << "-" << reinterpret_cast<uintptr_t>(this)
+             << "-" << runCounter++ << ".run";
+        return path.str();
+    }
+
+    /**
+     * Sorts the buffer, writes it as a new run and empties it
+     */
+    bool spill(std::string &error)
+    {
+        parallelSort(records, order);
+
+        std::string path = nextRunPath();
+        runs.push_back(path);
+        std::vector<char> buffer(std::min(MAX_RUN_BUFFER_BYTES, options.memoryBudget / 4 + 1));
+        std::ofstream out;
+        out.rdbuf()->pubsetbuf(&buffer[0], buffer.size());
+        out.open(path.c_str(), std::ios::binary);
+        for (size_t i = 0; i < records.size() && out; ++i)
+        {
+            out.write(reinterpret_cast<const char *>(&records[i]), sizeof(SortRecord));
+            out.write(descriptions.data() + records[i].descriptionOffset, records[i].descriptionLength);
+        }
+        out.close();
+        if (out.fail())
+        {
+            error = "Error: Cannot write sort run " + path + ".";
+            return false;
+        }
+
+        // Release the buffer's memory, not just its contents
+        std::vector<SortRecord>().swap(records);
+        std::vector<char>().swap(descriptions);
+        return true;
+    }
+
+    /**
+     * Heap-merges run files, calling emit(record, description) in order
+     */
+    template <typename Emit>
+    bool mergeRuns(const std::vector<std::string> &paths, Emit emit, std::string &error)
+    {
+        size_t bufferBytes = std::min(MAX_RUN_BUFFER_BYTES, options.memoryBudget / (2 * paths.size()) + 1);
+        std::vector<RunReader *> readers;
+        ReaderAfter after = {&readers, order};
+        std::vector<size_t> heap;
+        bool ok = true;
+
+        for (size_t i = 0; i < paths.size() && ok; ++i)
+        {
+            RunReader *reader = new RunReader();
+            readers.push_back(reader);
+            reader->path = paths[i];
+            reader->buffer.resize(bufferBytes);
+            reader->file.rdbuf()->pubsetbuf(&reader->buffer[0], reader->buffer.size());
+            reader->file.open(paths[i].c_str(), std::ios::binary);
+            if (!reader->file)
+            {
+                error = "Error: Cannot read sort run " + paths[i] + ".";
+                ok = false;
+            }
+            else if (reader->next())
+            {
+                heap.push_back(i);
+            }
+            else if (reader->failed)
+            {
+                error = "Error: Sort run " + paths[i] + " is truncated or unreadable.";
+                ok = false;
+            }
+        }
+        std::make_heap(heap.begin(), heap.end(), after);
+
+        while (ok && !heap.empty())
+        {
+            std::pop_heap(heap.begin(), heap.end(), after);
+            RunReader *reader = readers[heap.back()];
+            emit(reader->record, reader->description.data());
+            if (reader->next())
+            {
+                std::push_heap(heap.begin(), heap.end(), after);
+            }
+            else if (reader->failed)
+            {
+                // A run cut short would silently drop rows from the output
+                error = "Error: Sort run " + reader->path + " is truncated or unreadable.";
+                ok = false;
+            }
+            else
+            {
+                heap.pop_back();
+            }
+        }
+
+        for (size_t i = 0; i < readers.size(); ++i)
+        {
+            delete readers[i];
+        }
+        return ok;
+    }
+
+    ExpenseSorter(const ExpenseSorter &);
+    ExpenseSorter &operator=(const ExpenseSorter &);
+};
+
+// ============================================================================
+// EXPENSE TRACKER CLASS
+// ============================================================================
+
+class ExpenseTracker
+{
+public:
+    /**
+     * Constructor - initializes an in-memory tracker with no ledger attached
+     */
+    ExpenseTracker() : resident(categories), alertsNeedSeeding(false), rangeIndex(NULL)
+    {
+        ledger = NULL;
+    }
+
+    /**
+     * Destructor - cleans up dynamically allocated memory
+     */
+    ~ExpenseTracker()
+    {
+        delete rangeIndex.load();
+        delete ledger;
+    }
+
+    /**
+     * Attaches an on-disk ledger; its segments are loaded lazily by queries
+     * and new expenses are appended to it instead of being kept in memory
+     * @param manifestPath Path of the ledger manifest (created if missing)
+     * @param memoryCapBytes Loaded segments above this size are evicted
+     * @param error Set to a user-facing message on failure
+     * @return true if the ledger was opened
+     */
+    bool openLedger(const std::string &manifestPath, size_t memoryCapBytes, std::string &error)
+    {
+        SegmentStore *store = new SegmentStore(manifestPath, memoryCapBytes, categories);
+        if (!store->open(error))
+        {
+            delete store;
+            return false;
+        }
+        delete ledger;
+        ledger = store;
+        alertsNeedSeeding = alertsNeedSeeding || (!alerts.empty() && store->getRowCount() > 0);
+        return true;
+    }
+
+    /**
+     * Loads budget/threshold alert rules evaluated on every insert
+     * @param error Set to a user-facing message on failure
+     * @return false if the rules file cannot be read or parsed
+     */
+    bool loadAlertRules(const std::string &path, std::string &error)
+    {
+        if (!alerts.loadRules(path, categories, error))
+            return false;
+        alertsNeedSeeding = alertsNeedSeeding || getCount() > 0; // Older rows are not seen by onInsert
+        return true;
+    }
+
+    /**
+     * Appends alerts to a file
+     * @return false if the file cannot be opened
+     */
+    bool setAlertOutput(const std::string &path, std::string &error)
+    {
+        return alerts.setOutputFile(path, error);
+    }
+
+    /**
+     * Sends alerts to a stream such as std::cout; without an output set,
+     * alerts are evaluated but not written anywhere
+     */
+    void setAlertOutput(std::ostream &out)
+    {
+        alerts.setOutputStream(out);
+    }
+
+    /**
+     * Writes pending ledger metadata to disk (no-op without a ledger)
+     * @param error Set to a user-facing message on failure
+     * @return false if the manifest cannot be written
+     */
+    bool flushLedger(std::string &error)
+    {
+        return ledger == NULL || ledger->saveManifest(error);
+    }
+
+    /**
+     * Moves messages about ledger problems found while answering queries
+     * (unreadable month files, skipped malformed rows) into messages
+     * Queries report no errors themselves; front ends collect these instead.
+     */
+    void takeWarnings(std::vector<std::string> &messages)
+    {
+        if (ledger != NULL)
+            ledger->takeWarnings(messages);
+    }
+
+    /**
+     * Adds a new expense without printing anything
+     * @param date Date of expense (YYYY-MM-DD format)
+     * @param amount Amount of expense (positive value)
+     * @param category Category of expense
+     * @param description Description of expense
+     * @param error Set to a user-facing message when the expense is rejected
+     * @return true if the expense was stored
+     */
+    bool insertExpense(const std::string &date, float amount, const std::string &category,
+                       const std::string &description, std::string &error)
+    {
+        return insertExpense(date, amountToCents(amount), category, description, error);
+    }
+
+    /**
+     * Adds a new expense given its exact amount, without printing anything
+     * @param date Date of expense (YYYY-MM-DD format)
+     * @param cents Amount of expense in cents (positive value)
+     * @param category Category of expense
+     * @param description Description of expense
+     * @param error Set to a user-facing message when the expense is rejected
+     * @return true if the expense was stored
+     */
+    bool insertExpense(const std::string &date, int64_t cents, const std::string &category,
+                       const std::string &description, std::string &error)
+    {
+        try
+        {
+            // Validate required inputs
+            if (category.empty())
+            {
+                error = "Error: Category cannot be empty.";
+                return false;
+            }
+            if (description.empty())
+            {
+                error = "Error: Description cannot be empty.";
+                return false;
+            }
+
+            // Encode the date and amount in their compact forms
+            int32_t day;
+            if (!parseDayNumber(date, day))
+            {
+                error = "Error: Invalid date format. Please use YYYY-MM-DD format.";
+                return false;
+            }
+            if (cents <= 0)
+            {
+                error = "Error: Amount must be positive.";
+                return false;
+            }
+            if (cents > MAX_AMOUNT_CENTS)
+            {
+                error = "Error: Amount is too large.";
+                return false;
+            }
+
+            uint16_t categoryId = internCategory(category);
+            if (duplicates.isEnabled())
+            {
+                duplicates.recordStored(expenseFingerprint(day, static_cast<int32_t>(cents), categoryId,
+                                                           description.data(), description.size()),
+                                        day);
+            }
+            return storeExpense(day, static_cast<int32_t>(cents), categoryId, description, error);
+        }
+        catch (const std::bad_alloc &e)
+        {
+            // Handle memory allocation failure
+            error = "Error: Memory allocation failed. Cannot add expense.";
+        }
+        catch (const std::exception &e)
+        {
+            // Handle any other exceptions
+            error = std::string("Error adding expense: ") + e.what();
+        }
+        return false;
+    }
+
+    /**
+     * Turns on duplicate detection for imports and fingerprints the stored
+     * rows that fall inside the lookback window
+     * @param lookbackDays Days before the newest stored date to check (0 = all history)
+     */
+    void enableDuplicateDetection(int lookbackDays)
+    {
+        duplicates.enable(lookbackDays);
+
+        // Seed with the rows inside the window ending at the newest stored date
+        int32_t newestDay = std::numeric_limits<int32_t>::min();
+        if (ledger != NULL)
+        {
+            for (int s = 0; s < ledger->getSegmentCount(); ++s)
+            {
+                const LedgerSegment &segment = ledger->getSegment(s);
+                if (segment.rowCount > 0 && segment.lastDay > newestDay)
+                    newestDay = segment.lastDay;
+            }
+        }
+        for (int i = 0; i < resident.getSize(); ++i)
+        {
+            newestDay = std::max(newestDay, resident.at(i).day);
+        }
+        if (newestDay == std::numeric_limits<int32_t>::min())
+            return; // Nothing stored yet
+
+        int32_t startDay = lookbackDays > 0 ? newestDay - lookbackDays : std::numeric_limits<int32_t>::min();
+        forEachExpenseInRange(startDay, newestDay, [&](const ExpenseRef &expense)
+        {
+            duplicates.recordStored(expenseFingerprint(expense.day, expense.cents, expense.categoryId,
+                                                       expense.description, expense.descriptionLength),
+                                    expense.day);
+        });
+    }
+
+    /**
+     * Bulk-imports expenses from a file in the ledger row format
+     * (date <TAB> amount <TAB> category <TAB> description per line)
+     * Rows matching stored rows are skipped when duplicate detection is on
+     * @param report Filled with counts and the first skipped duplicates
+     * @param error Set to a user-facing message on failure
+     * @return false if the file cannot be read or a row cannot be stored
+     */
+    bool importExpenses(const std::string &path, ImportReport &report, std::string &error)
+    {
+        report.rowsRead = report.imported = report.duplicates = report.malformed = 0;
+        report.duplicateRows.clear();
+
+        std::vector<char> buffer(1 << 20);
+        std::ifstream file;
+        file.rdbuf()->pubsetbuf(&buffer[0], buffer.size());
+        file.open(path.c_str());
+        if (!file)
+        {
+            error = "Error: Cannot read import file " + path + ".";
+            return false;
+        }
+
+        duplicates.beginImport();
+        if (ledger != NULL)
+            ledger->beginBatch();
+
+        bool ok = true;
+        LedgerLineBatch batch;
+        std::string category, description;
+        int32_t day, cents;
+        long lineNumber = 0;
+        while (ok && batch.read(file))
+        {
+            for (size_t i = 0; ok && i < batch.size(); ++i)
+            {
+                const std::string &line = batch.line(i);
+                lineNumber++;
+                if (line.empty() || line == "\r")
+                    continue;
+                report.rowsRead++;
+                if (!batch.dateOf(i, day) || !parseLedgerFields(line, cents, category, description))
+                {
+                    report.malformed++;
+                    continue;
+                }
+
+                uint16_t categoryId = internCategory(category);
+                if (duplicates.isEnabled() &&
+                    duplicates.checkImported(expenseFingerprint(day, cents, categoryId, description.data(), description.size()), day))
+                {
+                    report.duplicates++;
+                    if (report.duplicateRows.size() < MAX_REPORTED_DUPLICATES)
+                    {
+                        std::ostringstream row;
+                        row << "line " << lineNumber << ": " << line;
+                        report.duplicateRows.push_back(row.str());
+                    }
+                    continue;
+                }
+
+                try
+                {
+                    ok = storeExpense(day, cents, categoryId, description, error);
+                }
+                catch (const std::exception &e)
+                {
+                    error = std::string("Error importing expense: ") + e.what();
+                    ok = false;
+                }
+                if (ok)
+                    report.imported++;
+            }
+        }
+
+        if (ledger != NULL)
+        {
+            ok = ledger->endBatch(error) && ok;
+            ok = ledger->saveManifest(error) && ok;
+        }
+        return ok;
+    }
+
+    /**
+     * Calls fn(const ExpenseRef &) for every stored expense in insertion order
+     * (ledger segments are visited month by month)
+     * Lets other front ends (e.g. server mode) read the data without printing
+     */
+    template <typename Fn>
+    void forEachExpense(Fn fn) const
+    {
+        forEachExpenseInRange(std::numeric_limits<int32_t>::min(), std::numeric_limits<int32_t>::max(), fn);
+    }
+
+    /**
+     * Calls fn(const ExpenseRef &) for every expense dated in [startDay, endDay]
+     * Ledger segments outside the range are skipped without being loaded
+     * @param startDay First day number included
+     * @param endDay Last day number included
+     */
+    template <typename Fn>
+    void forEachExpenseInRange(int32_t startDay, int32_t endDay, Fn fn) const
+    {
+        for (int i = 0; i < resident.getSize(); ++i)
+        {
+            ExpenseRef expense = resident.at(i);
+            if (expense.day >= startDay && expense.day <= endDay)
+                fn(expense);
+        }
+
+        if (ledger == NULL)
+            return;
+        for (int s = 0; s < ledger->getSegmentCount(); ++s)
+        {
+            if (!ledger->overlaps(s, startDay, endDay))
+                continue;
+            SegmentPin pin(*ledger, ledger->segmentAt(s));
+            const ExpenseTable *rows = pin.get();
+            if (rows == NULL)
+                continue;
+            for (int i = 0; i < rows->getSize(); ++i)
+            {
+                ExpenseRef expense = rows->at(i);
+                if (expense.day >= startDay && expense.day <= endDay)
+                    fn(expense);
+            }
+        }
+    }
+
+    /**
+     * @return Number of expenses currently stored (ledger rows are counted
+     *         from segment metadata, without loading them)
+     */
+    int getCount() const
+    {
+        return resident.getSize() + (ledger != NULL ? ledger->getRowCount() : 0);
+    }
+
+    /**
+     * @return ID of a category for comparisons against ExpenseRef::categoryId,
+     *         or -1 if no expense has ever used it
+     */
+    int findCategory(const std::string &category) const
+    {
+        return categories.find(category);
+    }
+
+    /**
+     * Collects storage statistics for the in-memory rows and loaded segments
+     */
+    void getMemoryReport(MemoryReport &report) const
+    {
+        memset(&report, 0, sizeof(report));
+        resident.addToReport(report);
+        if (ledger != NULL)
+            ledger->addToReport(report);
+        report.categoryCount = categories.getCount();
+        report.categoryBytes = categories.memoryBytes();
+        const RangeTotalsIndex *index = rangeIndex.load(std::memory_order_acquire);
+        report.rangeIndexBytes = index != NULL ? index->memoryBytes() : 0;
+    }
+
+    /**
+     * Totals the expenses dated in [startDay, endDay] in O(log days)
+     * The index is built by one pass over the stored rows on first use and
+     * kept up to date by every insert after that
+     * @param categoryId Category from findCategory(), or -1 for all categories
+     * @throws bad_alloc if the index cannot be built
+     */
+    ExpenseTotals getRangeTotals(int32_t startDay, int32_t endDay, int categoryId = -1) const
+    {
+        if (categoryId < -1)
+        {
+            ExpenseTotals none = {0, 0};
+            return none; // Unknown category name looked up by the caller
+        }
+        return ensureRangeIndex().range(startDay, endDay, categoryId);
+    }
+
+    /**
+     * Totals one category's expenses dated in [startDay, endDay]
+     */
+    ExpenseTotals getRangeTotals(int32_t startDay, int32_t endDay, const std::string &category) const
+    {
+        int categoryId = findCategory(category);
+        if (categoryId < 0)
+        {
+            ExpenseTotals none = {0, 0};
+            return none;
+        }
+        return getRangeTotals(startDay, endDay, categoryId);
+    }
+
+    /**
+     * Calls fn(const ExpenseRef &) for every expense in one category
+     * @param categoryId ID from findCategory(); -1 matches nothing
+     */
+    template <typename Fn>
+    void forEachExpenseInCategory(int categoryId, Fn fn) const
+    {
+        if (categoryId < 0)
+            return;
+        forEachExpense([&](const ExpenseRef &expense)
+        {
+            if (expense.categoryId == categoryId)
+                fn(expense);
+        });
+    }
+
+    /**
+     * Reorders a selection's row IDs in place; ties keep their current order
+     * Large selections are sorted in parallel chunks
+     */
+    void sortSelection(ExpenseSelection &selection, SortKey key, bool descending) const
+    {
+        // Sort (key, position) records, then permute the row IDs to match
+        std::vector<SortRecord> records(selection.size());
+        for (size_t i = 0; i < records.size(); ++i)
+        {
+            ExpenseRef row = selection[i];
+            memset(&records[i], 0, sizeof(SortRecord));
+            records[i].key = sortKeyOf(row, key, descending);
+            records[i].sequence = i;
+            records[i].categoryId = row.categoryId;
+        }
+        SortRecordOrder order = {key == SORT_BY_CATEGORY ? &categories : NULL, descending};
+        parallelSort(records, order);
+
+        std::vector<RowId> sorted(records.size());
+        for (size_t i = 0; i < records.size(); ++i)
+        {
+            sorted[i] = selection.ids[records[i].sequence];
+        }
+        selection.ids.swap(sorted);
+    }
+
+    /**
+     * Calls fn(const ExpenseRef &) for the expenses dated in [startDay, endDay]
+     * in sort order, optionally limited to one category
+     * Rows beyond the memory budget are spilled to sorted run files and
+     * merged lazily, so the selection may be far larger than memory
+     * @param categoryId Category from findCategory(), or -1 for all categories
+     * @param error Set to a user-facing message on failure
+     * @return false if run files could not be written or read
+     */
+    template <typename Fn>
+    bool forEachSorted(int32_t startDay, int32_t endDay, int categoryId, const SortOptions &options,
+                       Fn fn, std::string &error) const
+    {
+        ExpenseSorter sorter(categories, options);
+        bool ok = true;
+        forEachExpenseInRange(startDay, endDay, [&](const ExpenseRef &expense)
+        {
+            if (ok && (categoryId < 0 || expense.categoryId == categoryId))
+                ok = sorter.add(expense, error);
+        });
+        return ok && sorter.finish(fn, error);
+    }
+
+    /**
+     * @return Every stored expense, in the order forEachExpense visits them
+     */
+    ExpenseSelection selectAll() const
+    {
+        return selectWhere(std::numeric_limits<int32_t>::min(), std::numeric_limits<int32_t>::max(),
+                           [](const ExpenseRef &) { return true; });
+    }
+
+    /**
+     * @return Expenses dated in [startDay, endDay]; ledger segments outside
+     *         the range are neither loaded nor pinned
+     */
+    ExpenseSelection selectDateRange(int32_t startDay, int32_t endDay) const
+    {
+        return selectWhere(startDay, endDay, [](const ExpenseRef &) { return true; });
+    }
+
+    /**
+     * @param categoryId ID from findCategory(); -1 selects nothing
+     * @return Expenses in one category
+     */
+    ExpenseSelection selectCategory(int categoryId) const
+    {
+        if (categoryId < 0)
+            return ExpenseSelection();
+        return selectWhere(std::numeric_limits<int32_t>::min(), std::numeric_limits<int32_t>::max(),
+                           [categoryId](const ExpenseRef &expense) { return expense.categoryId == categoryId; });
+    }
+
+    /**
+     * @return Expenses in one category (exact, case-sensitive name)
+     */
+    ExpenseSelection selectCategory(const std::string &category) const
+    {
+        return selectCategory(findCategory(category));
+    }
+
+    /**
+     * Builds a selection from the expenses dated in [startDay, endDay] for
+     * which keep(const ExpenseRef &) returns true
+     */
+    template <typename Predicate>
+    ExpenseSelection selectWhere(int32_t startDay, int32_t endDay, Predicate keep) const
+    {
+        ExpenseSelection selection;
+        selection.ledger = ledger;
+        selection.tables.push_back(&resident);
+        for (int i = 0; i < resident.getSize(); ++i)
+        {
+            ExpenseRef expense = resident.at(i);
+            if (expense.day >= startDay && expense.day <= endDay && keep(expense))
+            {
+                RowId id = {0, static_cast<uint32_t>(i)};
+                selection.ids.push_back(id);
+            }
+        }
+
+        if (ledger == NULL)
+            return selection;
+        selection.tables.resize(ledger->getSegmentCount() + 1, NULL);
+        for (int s = 0; s < ledger->getSegmentCount(); ++s)
+        {
+            if (!ledger->overlaps(s, startDay, endDay))
+                continue;
+            LedgerSegment *segment = ledger->segmentAt(s);
+            const ExpenseTable *rows = ledger->pin(segment);
+            if (rows == NULL)
+                continue;
+            selection.tables[s + 1] = rows;
+            selection.pinnedSegments.push_back(segment);
+            size_t before = selection.ids.size();
+            for (int i = 0; i < rows->getSize(); ++i)
+            {
+                ExpenseRef expense = rows->at(i);
+                if (expense.day >= startDay && expense.day <= endDay && keep(expense))
+                {
+                    RowId id = {static_cast<uint32_t>(s + 1), static_cast<uint32_t>(i)};
+                    selection.ids.push_back(id);
+                }
+            }
+
+            // Keep the segment pinned only if the selection points into it
+            if (selection.ids.size() == before)
+            {
+                selection.tables[s + 1] = NULL;
+                selection.pinnedSegments.pop_back();
+                ledger->unpin(segment);
+            }
+        }
+        return selection;
+    }
+
+    /**
+     * Calculates per-category and overall totals without printing
+     * @param summary Filled with categories in first-seen order
+     */
+    void computeSummary(ExpenseSummary &summary) const
+    {
+        summary.categoryCount = 0;
+        summary.totalExpensesCents = 0;
+        summary.overflow = false;
+
+        // Summary slot for each category ID (-1 = not seen yet)
+        std::vector<int> slotForCategory(categories.getCount(), -1);
+
+        // Process each expense to calculate category totals
+        forEachExpense([&](const ExpenseRef &expense)
+        {
+            if (expense.categoryId >= slotForCategory.size())
+                slotForCategory.resize(expense.categoryId + 1, -1);
+            int &slot = slotForCategory[expense.categoryId];
+
+            // Add new category if not seen yet
+            if (slot < 0)
+            {
+                if (summary.categoryCount < MAX_CATEGORIES)
+                {
+                    slot = summary.categoryCount++;
+                    summary.categories[slot] = *expense.category;
+                    summary.totalCents[slot] = 0;
+                }
+                else
+                {
+                    summary.overflow = true;
+                }
+            }
+            if (slot >= 0)
+            {
+                summary.totalCents[slot] += expense.cents;
+            }
+
+            // Add to overall total
+            summary.totalExpensesCents += expense.cents;
+        });
+    }
+
+private:
+    // Member variables
+    CategoryTable categories; // Category names shared by every table
+    ExpenseTable resident;    // Expenses kept in memory when no ledger is attached
+    SegmentStore *ledger;     // Lazily loaded on-disk ledger, or NULL
+    AlertEngine alerts;       // Budget/threshold rules checked on insert
+    bool alertsNeedSeeding;   // Rows were stored before the rules, so periods need seeding
+    DuplicateDetector duplicates; // Fingerprints used to skip re-imported rows
+    mutable std::atomic<RangeTotalsIndex *> rangeIndex; // Built on first range-total query
+    mutable std::mutex rangeIndexMutex;                // Serializes that first build
+
+    /**
+     * Returns the date-range index, building it from the stored rows if needed
+     * Safe to call from concurrent readers; inserts must be excluded by the caller
+     */
+    const RangeTotalsIndex &ensureRangeIndex() const
+    {
+        RangeTotalsIndex *index = rangeIndex.load(std::memory_order_acquire);
+        if (index != NULL)
+            return *index;
+
+        std::lock_guard<std::mutex> guard(rangeIndexMutex);
+        index = rangeIndex.load(std::memory_order_relaxed);
+        if (index == NULL)
+        {
+            RangeTotalsIndex *built = new RangeTotalsIndex();
+            try
+            {
+                forEachExpense([built](const ExpenseRef &expense)
+                {
+                    built->add(expense.day, expense.cents, expense.categoryId);
+                });
+            }
+            catch (...)
+            {
+                delete built;
+                throw;
+            }
+            rangeIndex.store(built, std::memory_order_release);
+            index = built;
+        }
+        return *index;
+    }
+
+    /**
+     * Interns a category name as it will be stored
+     * (ledger rows are tab-separated, so their categories must be too)
+     */
+    uint16_t internCategory(const std::string &category)
+    {
+        return categories.intern(ledger != NULL ? sanitizeLedgerField(category) : category);
+    }
+
+    /**
+     * Stores an already validated and encoded expense and evaluates alert rules
+     * @param error Set to a user-facing message on failure
+     * @throws bad_alloc if memory cannot be allocated
+     */
+    bool storeExpense(int32_t day, int32_t cents, uint16_t categoryId, const std::string &description, std::string &error)
+    {
+        if (ledger != NULL)
+        {
+            if (!ledger->append(day, cents, categoryId, description, error))
+                return false;
+        }
+        else
+        {
+            resident.append(day, cents, categoryId, description);
+        }
+        RangeTotalsIndex *index = rangeIndex.load(std::memory_order_relaxed);
+        if (index != NULL)
+            index->add(day, cents, categoryId);
+
+        if (!alerts.empty())
+        {
+            ExpenseRef stored;
+            stored.day = day;
+            stored.cents = cents;
+            stored.categoryId = categoryId;
+            stored.category = &categories.getName(categoryId);
+            stored.description = description.data();
+            stored.descriptionLength = static_cast<uint16_t>(std::min(description.size(), MAX_DESCRIPTION_LENGTH));
+            alerts.onInsert(stored, [this, &stored](int32_t startDay, int32_t endDay, PeriodTotals &totals)
+            {
+                if (!alertsNeedSeeding)
+                {
+                    totals.add(stored.categoryId, stored.cents); // Nothing older to count
+                    return;
+                }
+
+                // The index already includes this expense; only watched categories are read
+                const RangeTotalsIndex &index = ensureRangeIndex();
+                totals.total = index.range(startDay, endDay, -1).totalCents;
+                for (int c = 0; c < categories.getCount(); ++c)
+                {
+                    if (!alerts.hasCategoryBudget(c))
+                        continue;
+                    totals.add(static_cast<uint16_t>(c), 0);
+                    totals.byCategory[c] = index.range(startDay, endDay, c).totalCents;
+                }
+            });
+        }
+        return true;
+    }
+
+    ExpenseTracker(const ExpenseTracker &);
+    ExpenseTracker &operator=(const ExpenseTracker &);
+};
+
+#endif // EXPENSE_ENGINE_H
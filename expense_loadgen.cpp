@@ -0,0 +1,236 @@
+// -------------------------------------------
+// MSCS 632 Advanced Programming Languages
+// Group Project
+// Expense Tracker App - Query Daemon Load Generator
+// -------------------------------------------
+//
+// Opens several connections to a tracker started with --serve, issues a mix
+// of add/filter/summary requests and reports throughput and latency
+// percentiles. Each connection runs on its own thread and keeps exactly one
+// request in flight, measuring the full round trip.
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <thread>
+#include <chrono>
+#include <algorithm>
+#include <cstdlib>
+#include <cstdio>
+#include "expense_protocol.h"
+using namespace std;
+
+const char *LOADGEN_CATEGORIES[] = {"Food", "Transport", "Travel", "Utilities", "Entertainment"};
+const int LOADGEN_CATEGORY_COUNT = 5;
+
+struct LoadgenOptions
+{
+    string socketPath;
+    int connections;   // Concurrent client connections
+    int requests;      // Requests sent by each connection
+    int writePercent;  // Share of requests that are adds (0-100)
+};
+
+struct ConnectionResult
+{
+    vector<double> latenciesUs; // Round-trip time of each successful request
+    int errors;                 // Requests that failed or returned STATUS_ERROR
+};
+
+/**
+ * Prints command-line usage
+ */
+void printUsage(const char *program)
+{
+    cout << "Usage: " << program << " SOCKET [-c connections] [-n requests-per-connection] [-w write-percent]\n";
+}
+
+/**
+ * Small per-thread xorshift generator so threads never contend on rand()
+ */
+uint32_t nextRandom(uint32_t &state)
+{
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+/**
+ * Formats a day of 2025 as YYYY-MM-DD (months treated as 28 days for simplicity)
+ */
+string randomDate(uint32_t &state)
+{
+    char buffer[16];
+    snprintf(buffer, sizeof(buffer), "2025-%02u-%02u", nextRandom(state) % 12 + 1, nextRandom(state) % 28 + 1);
+    return buffer;
+}
+
+/**
+ * Builds the next request for a connection
+ */
+string buildRequest(uint32_t &state, int writePercent)
+{
+    FrameWriter writer;
+    const char *category = LOADGEN_CATEGORIES[nextRandom(state) % LOADGEN_CATEGORY_COUNT];
+
+    if (static_cast<int>(nextRandom(state) % 100) < writePercent)
+    {
+        writer.begin(OP_ADD);
+        writer.putDate(randomDate(state));
+        writer.putI64(static_cast<int64_t>(nextRandom(state) % 50000 + 1));
+        writer.putString(category);
+        writer.putString("loadgen expense");
+        return writer.finish();
+    }
+
+    switch (nextRandom(state) % 3)
+    {
+    case 0:
+        writer.begin(OP_SUMMARY);
+        break;
+    case 1:
+    {
+        string start = randomDate(state);
+        string end = randomDate(state);
+        if (start > end)
+            swap(start, end);
+        writer.begin(OP_FILTER_DATE);
+        writer.putDate(start);
+        writer.putDate(end);
+        break;
+    }
+    default:
+        writer.begin(OP_FILTER_CATEGORY);
+        writer.putString(category);
+    }
+    return writer.finish();
+}
+
+/**
+ * Body of one connection thread
+ */
+void runConnection(const LoadgenOptions &options, int index, ConnectionResult &result)
+{
+    result.errors = 0;
+    int fd = connectToDaemon(options.socketPath);
+    if (fd < 0)
+    {
+        result.errors = options.requests;
+        return;
+    }
+
+    uint32_t state = 2463534242u + static_cast<uint32_t>(index) * 7919u;
+    result.latenciesUs.reserve(options.requests);
+    string response;
+    for (int i = 0; i < options.requests; ++i)
+    {
+        string request = buildRequest(state, options.writePercent);
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        if (!sendAll(fd, request) || !receiveFrame(fd, response))
+        {
+            result.errors += options.requests - i;
+            break;
+        }
+        chrono::steady_clock::time_point end = chrono::steady_clock::now();
+
+        if (static_cast<uint8_t>(response[0]) != STATUS_OK)
+        {
+            result.errors++;
+            continue;
+        }
+        result.latenciesUs.push_back(chrono::duration<double, micro>(end - start).count());
+    }
+    close(fd);
+}
+
+/**
+ * Returns the given percentile of an already sorted sample
+ */
+double percentile(const vector<double> &sorted, double fraction)
+{
+    if (sorted.empty())
+        return 0.0;
+    size_t index = static_cast<size_t>(fraction * (sorted.size() - 1) + 0.5);
+    return sorted[index];
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc < 2)
+    {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    LoadgenOptions options;
+    options.socketPath = argv[1];
+    options.connections = 8;
+    options.requests = 10000;
+    options.writePercent = 10;
+
+    // Parse command-line options
+    for (int i = 2; i < argc; ++i)
+    {
+        string option = argv[i];
+        if (i + 1 >= argc)
+        {
+            printUsage(argv[0]);
+            return 1;
+        }
+        if (option == "-c")
+            options.connections = atoi(argv[++i]);
+        else if (option == "-n")
+            options.requests = atoi(argv[++i]);
+        else if (option == "-w")
+            options.writePercent = atoi(argv[++i]);
+        else
+        {
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+    if (options.connections <= 0 || options.requests <= 0 ||
+        options.writePercent < 0 || options.writePercent > 100)
+    {
+        cout << "Error: Connections and requests must be positive; write percent must be 0-100.\n";
+        return 1;
+    }
+
+    // Run every connection on its own thread
+    vector<ConnectionResult> results(options.connections);
+    vector<thread> threads;
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    for (int i = 0; i < options.connections; ++i)
+    {
+        threads.push_back(thread(runConnection, cref(options), i, ref(results[i])));
+    }
+    for (size_t i = 0; i < threads.size(); ++i)
+    {
+        threads[i].join();
+    }
+    double elapsed = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    // Merge and report
+    vector<double> latencies;
+    int errors = 0;
+    for (size_t i = 0; i < results.size(); ++i)
+    {
+        latencies.insert(latencies.end(), results[i].latenciesUs.begin(), results[i].latenciesUs.end());
+        errors += results[i].errors;
+    }
+    sort(latencies.begin(), latencies.end());
+
+    cout << fixed << setprecision(1);
+    cout << "Connections:   " << options.connections << "\n"
+         << "Requests:      " << latencies.size() << " ok, " << errors << " failed\n"
+         << "Write share:   " << options.writePercent << "%\n"
+         << "Elapsed:       " << elapsed << " s\n"
+         << "Throughput:    " << (elapsed > 0 ? latencies.size() / elapsed : 0.0) << " req/s\n"
+         << "Latency p50:   " << percentile(latencies, 0.50) << " us\n"
+         << "Latency p99:   " << percentile(latencies, 0.99) << " us\n"
+         << "Latency max:   " << (latencies.empty() ? 0.0 : latencies.back()) << " us\n";
+
+    return errors == 0 ? 0 : 1;
+}
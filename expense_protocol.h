@@ -0,0 +1,321 @@
+// -------------------------------------------
+// MSCS 632 Advanced Programming Languages
+// Group Project
+// Expense Tracker App - Query Daemon Protocol
+// -------------------------------------------
+//
+// Shared by the tracker's server mode, expense_client and expense_loadgen.
+//
+// Every message is a length-prefixed frame (integers are little-endian):
+//
+//   u32 length   number of bytes that follow
+//   u8  code     request opcode, or response status
+//   ...          opcode-specific payload
+//
+// Strings are encoded as u16 length + bytes, dates as the raw 10 bytes of
+// YYYY-MM-DD and amounts as i64 cents so no floating point crosses the wire.
+
+#ifndef EXPENSE_PROTOCOL_H
+#define EXPENSE_PROTOCOL_H
+
+#include <string>
+#include <cstring>
+#include <cerrno>
+#include <stdint.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+// Request opcodes
+const uint8_t OP_PING = 0;            // (no payload)
+const uint8_t OP_ADD = 1;             // date, i64 cents, str category, str description
+const uint8_t OP_LIST_ALL = 2;        // (no payload)
+const uint8_t OP_FILTER_DATE = 3;     // date start, date end
+const uint8_t OP_FILTER_CATEGORY = 4; // str category
+const uint8_t OP_SUMMARY = 5;         // (no payload)
+const uint8_t OP_RANGE_TOTAL = 6;     // date start, date end, str category ("" = all categories)
+
+// Response status codes
+const uint8_t STATUS_OK = 0;    // payload depends on the request
+const uint8_t STATUS_ERROR = 1; // str message
+
+// Row list responses:    u32 count, then count x (date, i64 cents, str category, str description)
+// Summary responses:     u32 count, then count x (str category, i64 cents), then i64 total cents
+// Range total responses: i64 expense count, i64 total cents
+
+const int DATE_WIRE_LENGTH = 10;                       // YYYY-MM-DD
+const uint32_t MAX_WIRE_STRING = 0xFFFF;               // Longest string a u16 length can describe
+
+// Largest request the server accepts: an OP_ADD with both strings at full length
+const uint32_t MAX_REQUEST_FRAME = 1 + DATE_WIRE_LENGTH + 8 + 2 * (2 + MAX_WIRE_STRING);
+const uint32_t MAX_RESPONSE_FRAME = 1024 * 1024 * 1024; // Largest response a client accepts
+
+// ============================================================================
+// FRAME ENCODING
+// ============================================================================
+
+/**
+ * Builds a single frame in memory; the length prefix is patched by finish()
+ */
+class FrameWriter
+{
+public:
+    /**
+     * Starts a new frame, discarding anything written before
+     * @param code Opcode or status byte
+     */
+    void begin(uint8_t code)
+    {
+        buffer.assign(4, '\0');
+        putU8(code);
+    }
+
+    void putU8(uint8_t value) { buffer.push_back(static_cast<char>(value)); }
+
+    void putU16(uint16_t value)
+    {
+        for (int i = 0; i < 2; ++i)
+            buffer.push_back(static_cast<char>((value >> (8 * i)) & 0xFF));
+    }
+
+    void putU32(uint32_t value)
+    {
+        for (int i = 0; i < 4; ++i)
+            buffer.push_back(static_cast<char>((value >> (8 * i)) & 0xFF));
+    }
+
+    void putI64(int64_t value)
+    {
+        uint64_t bits = static_cast<uint64_t>(value);
+        for (int i = 0; i < 8; ++i)
+            buffer.push_back(static_cast<char>((bits >> (8 * i)) & 0xFF));
+    }
+
+    /**
+     * Writes a string, truncated to the 65535 bytes a u16 length can describe
+     */
+    void putString(const std::string &value)
+    {
+        putString(value.data(), value.size());
+    }
+
+    void putString(const char *data, size_t length)
+    {
+        if (length > MAX_WIRE_STRING)
+            length = MAX_WIRE_STRING;
+        putU16(static_cast<uint16_t>(length));
+        buffer.append(data, length);
+    }
+
+    /**
+     * Writes a YYYY-MM-DD date; short input is padded so framing stays intact
+     */
+    void putDate(const std::string &date)
+    {
+        std::string padded = date.substr(0, DATE_WIRE_LENGTH);
+        padded.resize(DATE_WIRE_LENGTH, ' ');
+        buffer.append(padded);
+    }
+
+    /**
+     * Patches the length prefix
+     * @return The complete frame, ready to send
+     */
+    const std::string &finish()
+    {
+        uint32_t length = static_cast<uint32_t>(buffer.size() - 4);
+        for (int i = 0; i < 4; ++i)
+            buffer[i] = static_cast<char>((length >> (8 * i)) & 0xFF);
+        return buffer;
+    }
+
+private:
+    std::string buffer;
+};
+
+/**
+ * Bounds-checked reader over one frame body (everything after the length)
+ * Any read past the end clears ok() instead of touching invalid memory
+ */
+class FrameReader
+{
+public:
+    FrameReader(const char *data, size_t length) : cursor(data), end(data + length), valid(true) {}
+
+    bool ok() const { return valid; }
+    bool atEnd() const { return cursor == end; }
+
+    uint8_t getU8()
+    {
+        if (!need(1))
+            return 0;
+        return static_cast<uint8_t>(*cursor++);
+    }
+
+    uint16_t getU16()
+    {
+        if (!need(2))
+            return 0;
+        uint16_t value = 0;
+        for (int i = 0; i < 2; ++i)
+            value |= static_cast<uint16_t>(static_cast<uint8_t>(*cursor++)) << (8 * i);
+        return value;
+    }
+
+    uint32_t getU32()
+    {
+        if (!need(4))
+            return 0;
+        uint32_t value = 0;
+        for (int i = 0; i < 4; ++i)
+            value |= static_cast<uint32_t>(static_cast<uint8_t>(*cursor++)) << (8 * i);
+        return value;
+    }
+
+    int64_t getI64()
+    {
+        if (!need(8))
+            return 0;
+        uint64_t bits = 0;
+        for (int i = 0; i < 8; ++i)
+            bits |= static_cast<uint64_t>(static_cast<uint8_t>(*cursor++)) << (8 * i);
+        return static_cast<int64_t>(bits);
+    }
+
+    std::string getString()
+    {
+        uint16_t length = getU16();
+        if (!need(length))
+            return std::string();
+        std::string value(cursor, length);
+        cursor += length;
+        return value;
+    }
+
+    std::string getDate()
+    {
+        if (!need(DATE_WIRE_LENGTH))
+            return std::string();
+        std::string value(cursor, DATE_WIRE_LENGTH);
+        cursor += DATE_WIRE_LENGTH;
+        return value;
+    }
+
+private:
+    const char *cursor;
+    const char *end;
+    bool valid;
+
+    bool need(size_t bytes)
+    {
+        if (!valid || static_cast<size_t>(end - cursor) < bytes)
+        {
+            valid = false;
+            return false;
+        }
+        return true;
+    }
+};
+
+/**
+ * Reads the little-endian length prefix at the start of a buffer
+ * @param data At least 4 bytes
+ */
+inline uint32_t decodeFrameLength(const char *data)
+{
+    uint32_t length = 0;
+    for (int i = 0; i < 4; ++i)
+        length |= static_cast<uint32_t>(static_cast<uint8_t>(data[i])) << (8 * i);
+    return length;
+}
+
+// ============================================================================
+// BLOCKING SOCKET HELPERS (client side)
+// ============================================================================
+
+/**
+ * Connects to the daemon's Unix domain socket
+ * @param path Filesystem path of the socket
+ * @return Connected file descriptor, or -1 on failure (errno is set)
+ */
+inline int connectToDaemon(const std::string &path)
+{
+    sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(address.sun_path))
+    {
+        errno = ENAMETOOLONG;
+        return -1;
+    }
+    memcpy(address.sun_path, path.c_str(), path.size());
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0)
+        return -1;
+    if (connect(fd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) < 0)
+    {
+        int saved = errno;
+        close(fd);
+        errno = saved;
+        return -1;
+    }
+    return fd;
+}
+
+/**
+ * Writes the whole buffer, retrying on short writes and EINTR
+ * @return true if every byte was written
+ */
+inline bool sendAll(int fd, const std::string &data)
+{
+    size_t sent = 0;
+    while (sent < data.size())
+    {
+        ssize_t n = send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return false;
+        sent += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+/**
+ * Reads exactly `length` bytes into `out`
+ * @return false on EOF or error
+ */
+inline bool receiveExactly(int fd, size_t length, std::string &out)
+{
+    out.resize(length);
+    size_t received = 0;
+    while (received < length)
+    {
+        ssize_t n = recv(fd, &out[received], length - received, 0);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return false;
+        received += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+/**
+ * Receives one response frame
+ * @param body Set to the frame body (status byte + payload)
+ * @return false on EOF, I/O error or an oversized frame
+ */
+inline bool receiveFrame(int fd, std::string &body)
+{
+    std::string header;
+    if (!receiveExactly(fd, 4, header))
+        return false;
+    uint32_t length = decodeFrameLength(header.data());
+    if (length == 0 || length > MAX_RESPONSE_FRAME)
+        return false;
+    return receiveExactly(fd, length, body);
+}
+
+#endif // EXPENSE_PROTOCOL_H
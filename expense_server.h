@@ -0,0 +1,791 @@
+// -------------------------------------------
+// MSCS 632 Advanced Programming Languages
+// Group Project
+// Expense Tracker App - Query Daemon (Linux only)
+// -------------------------------------------
+//
+// The --serve mode of expense_tracker: an epoll server answering the
+// requests described in expense_protocol.h against an ExpenseTracker.
+
+#ifndef EXPENSE_SERVER_H
+#define EXPENSE_SERVER_H
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <map>
+#include <deque>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <csignal>
+#include <cstring>
+#include <cerrno>
+#include <pthread.h>
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/signalfd.h>
+#include "expense_engine.h"
+#include "expense_protocol.h"
+
+// ============================================================================
+// QUERY SERVER
+// ============================================================================
+//
+// One event-loop thread owns the listening socket and every connection and
+// never touches the tracker lock, so a long list request cannot stall accept
+// or other clients. Read requests (list/filter/summary) are handed to a pool
+// of worker threads that share a reader lock on the tracker, so they run
+// concurrently. Add requests go to one writer thread, which applies every add
+// queued since its last pass under one writer lock, so a burst of inserts
+// costs one lock handoff. Each connection has at most one request in flight;
+// responses therefore come back in request order without needing request IDs
+// on the wire. While a request is in flight, at most one maximum-size frame
+// of further input is buffered; the socket is not read beyond that.
+
+const int SERVER_MAX_EVENTS = 64;       // epoll_wait batch size
+const int SERVER_LISTEN_BACKLOG = 128;  // Pending connections allowed by listen()
+const size_t SERVER_READ_CHUNK = 16384; // Bytes read per recv() call
+const size_t SERVER_MAX_INPUT = 4 + MAX_REQUEST_FRAME; // Buffered input per connection (one whole frame)
+
+/**
+ * Thin wrapper over pthread_rwlock_t (std::shared_mutex needs C++17)
+ * Writers are preferred so a stream of readers cannot starve the add path
+ */
+class ReadWriteLock
+{
+public:
+    ReadWriteLock()
+    {
+        pthread_rwlockattr_t attributes;
+        pthread_rwlockattr_init(&attributes);
+        pthread_rwlockattr_setkind_np(&attributes, PTHREAD_RWLOCK_PREFER_WRITER_NONRECURSIVE_NP);
+        pthread_rwlock_init(&lock, &attributes);
+        pthread_rwlockattr_destroy(&attributes);
+    }
+
+    ~ReadWriteLock() { pthread_rwlock_destroy(&lock); }
+    void lockShared() { pthread_rwlock_rdlock(&lock); }
+    void unlockShared() { pthread_rwlock_unlock(&lock); }
+    void lockExclusive() { pthread_rwlock_wrlock(&lock); }
+    void unlockExclusive() { pthread_rwlock_unlock(&lock); }
+
+private:
+    pthread_rwlock_t lock;
+    ReadWriteLock(const ReadWriteLock &);
+    ReadWriteLock &operator=(const ReadWriteLock &);
+};
+
+/**
+ * Appends one expense row to a response frame
+ */
+inline void encodeExpenseRow(FrameWriter &writer, const ExpenseRef &expense)
+{
+    char date[11];
+    formatDayNumber(expense.day, date);
+    writer.putDate(date);
+    writer.putI64(expense.cents);
+    writer.putString(*expense.category);
+    writer.putString(expense.description, expense.descriptionLength);
+}
+
+/**
+ * Builds an error response frame
+ */
+inline std::string errorFrame(const std::string &message)
+{
+    FrameWriter writer;
+    writer.begin(STATUS_ERROR);
+    writer.putString(message);
+    return writer.finish();
+}
+
+class QueryServer
+{
+public:
+    /**
+     * @param tracker Tracker served by this daemon (must outlive the server)
+     * @param socketPath Filesystem path of the Unix domain socket
+     * @param workerCount Number of threads serving read requests
+     * @param logStream Receives status lines, errors and ledger warnings
+     */
+    QueryServer(ExpenseTracker &tracker, const std::string &socketPath, int workerCount, std::ostream &logStream)
+        : tracker(tracker), socketPath(socketPath), workerCount(workerCount), logStream(logStream),
+          listenFd(-1), epollFd(-1), wakeFd(-1), signalFd(-1), nextConnectionId(1), stopping(false),
+          workersStopping(false)
+    {
+    }
+
+    ~QueryServer()
+    {
+        shutdown();
+    }
+
+    /**
+     * Binds the socket and runs the event loop until SIGINT/SIGTERM or stop()
+     * @return Process exit code
+     */
+    int run()
+    {
+        if (!setup())
+        {
+            shutdown();
+            return 1;
+        }
+
+        logStream << "Serving expense tracker on " << socketPath
+             << " with " << workerCount << " reader threads (Ctrl+C to stop)" << std::endl;
+
+        epoll_event events[SERVER_MAX_EVENTS];
+        while (!stopping)
+        {
+            int ready = epoll_wait(epollFd, events, SERVER_MAX_EVENTS, -1);
+            if (ready < 0)
+            {
+                if (errno == EINTR)
+                    continue;
+                logStream << "Error: epoll_wait failed: " << strerror(errno) << "\n";
+                break;
+            }
+
+            for (int i = 0; i < ready; ++i)
+            {
+                int fd = events[i].data.fd;
+                if (fd == listenFd)
+                    acceptConnections();
+                else if (fd == wakeFd)
+                    collectReplies();
+                else if (fd == signalFd)
+                    stopping = true;
+                else
+                    handleConnectionEvent(fd, events[i].events);
+            }
+            logWarnings();
+        }
+
+        logStream << "Server stopped." << std::endl;
+        shutdown();
+        return 0;
+    }
+
+    /**
+     * Asks a running event loop to stop; safe to call from any thread
+     */
+    void stop()
+    {
+        stopping = true;
+        wakeEventLoop();
+    }
+
+private:
+    struct Connection
+    {
+        int fd;
+        uint64_t id;
+        std::string input;  // Bytes received but not yet parsed
+        std::string output; // Bytes queued for sending
+        bool busy;     // A request from this connection is being processed
+        bool wantRead; // Input is below SERVER_MAX_INPUT, so the socket is polled for reading
+        bool wantWrite;
+    };
+
+    struct ReadJob
+    {
+        uint64_t connectionId;
+        std::string request; // Frame body: opcode + payload
+    };
+
+    struct Reply
+    {
+        uint64_t connectionId;
+        std::string frame;
+    };
+
+    struct PendingAdd
+    {
+        uint64_t connectionId;
+        std::string date;
+        int64_t cents;
+        std::string category;
+        std::string description;
+    };
+
+    ExpenseTracker &tracker;
+    std::string socketPath;
+    int workerCount;
+    std::ostream &logStream;
+    int listenFd;
+    int epollFd;
+    int wakeFd;   // eventfd signalled when replies are ready or stop() is called
+    int signalFd; // signalfd for SIGINT/SIGTERM
+    uint64_t nextConnectionId;
+    std::atomic<bool> stopping;
+
+    std::map<int, Connection> connections; // Keyed by file descriptor
+    std::map<uint64_t, int> connectionFds; // Connection ID -> file descriptor
+    ReadWriteLock trackerLock;             // Guards the tracker
+
+    std::vector<std::thread> workers;      // Reader threads, then the writer thread
+    std::mutex jobMutex;                   // Guards jobs, adds and workersStopping
+    std::condition_variable jobReady;
+    std::condition_variable addReady;
+    std::deque<ReadJob> jobs;
+    std::vector<PendingAdd> adds;          // Writes queued for the writer's next batch
+    bool workersStopping;
+
+    std::mutex replyMutex;
+    std::vector<Reply> replies;
+
+    /**
+     * Creates the socket, epoll instance, wake-up eventfd, signalfd, workers and writer
+     * @return false (after printing the reason) if anything fails
+     */
+    bool setup()
+    {
+        sockaddr_un address;
+        memset(&address, 0, sizeof(address));
+        address.sun_family = AF_UNIX;
+        if (socketPath.size() >= sizeof(address.sun_path))
+        {
+            logStream << "Error: Socket path is too long.\n";
+            return false;
+        }
+        memcpy(address.sun_path, socketPath.c_str(), socketPath.size());
+
+        // Route SIGINT/SIGTERM through epoll; the mask is inherited by workers
+        sigset_t signals;
+        sigemptyset(&signals);
+        sigaddset(&signals, SIGINT);
+        sigaddset(&signals, SIGTERM);
+        pthread_sigmask(SIG_BLOCK, &signals, NULL);
+        signalFd = signalfd(-1, &signals, SFD_NONBLOCK | SFD_CLOEXEC);
+
+        listenFd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        epollFd = epoll_create1(EPOLL_CLOEXEC);
+        wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (signalFd < 0 || listenFd < 0 || epollFd < 0 || wakeFd < 0)
+        {
+            logStream << "Error: Cannot create server descriptors: " << strerror(errno) << "\n";
+            return false;
+        }
+
+        unlink(socketPath.c_str()); // Remove a stale socket from an earlier run
+        if (bind(listenFd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) < 0 ||
+            listen(listenFd, SERVER_LISTEN_BACKLOG) < 0)
+        {
+            logStream << "Error: Cannot listen on " << socketPath << ": " << strerror(errno) << "\n";
+            return false;
+        }
+
+        watch(listenFd, EPOLLIN);
+        watch(wakeFd, EPOLLIN);
+        watch(signalFd, EPOLLIN);
+
+        workersStopping = false;
+        for (int i = 0; i < workerCount; ++i)
+        {
+            workers.push_back(std::thread(&QueryServer::workerLoop, this));
+        }
+        workers.push_back(std::thread(&QueryServer::writerLoop, this));
+        return true;
+    }
+
+    /**
+     * Stops workers, closes every descriptor and removes the socket file
+     */
+    void shutdown()
+    {
+        {
+            std::lock_guard<std::mutex> guard(jobMutex);
+            workersStopping = true;
+        }
+        jobReady.notify_all();
+        addReady.notify_all();
+        for (size_t i = 0; i < workers.size(); ++i)
+        {
+            workers[i].join();
+        }
+        workers.clear();
+
+        for (std::map<int, Connection>::iterator it = connections.begin(); it != connections.end(); ++it)
+        {
+            close(it->first);
+        }
+        connections.clear();
+        connectionFds.clear();
+
+        if (listenFd >= 0)
+        {
+            close(listenFd);
+            unlink(socketPath.c_str());
+            listenFd = -1;
+        }
+        int *fds[] = {&epollFd, &wakeFd, &signalFd};
+        for (int i = 0; i < 3; ++i)
+        {
+            if (*fds[i] >= 0)
+            {
+                close(*fds[i]);
+                *fds[i] = -1;
+            }
+        }
+    }
+
+    void watch(int fd, uint32_t events)
+    {
+        epoll_event event;
+        memset(&event, 0, sizeof(event));
+        event.events = events;
+        event.data.fd = fd;
+        epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event);
+    }
+
+    /**
+     * Polls a connection for reading only while its input has room, and for
+     * writing only while output is queued
+     */
+    void updateInterest(Connection &connection)
+    {
+        bool wantRead = connection.input.size() < SERVER_MAX_INPUT;
+        bool wantWrite = !connection.output.empty();
+        if (wantRead == connection.wantRead && wantWrite == connection.wantWrite)
+            return;
+        connection.wantRead = wantRead;
+        connection.wantWrite = wantWrite;
+
+        epoll_event event;
+        memset(&event, 0, sizeof(event));
+        event.events = (wantRead ? static_cast<uint32_t>(EPOLLIN | EPOLLRDHUP) : 0u) |
+                       (wantWrite ? static_cast<uint32_t>(EPOLLOUT) : 0u);
+        event.data.fd = connection.fd;
+        epoll_ctl(epollFd, EPOLL_CTL_MOD, connection.fd, &event);
+    }
+
+    void acceptConnections()
+    {
+        while (true)
+        {
+            int fd = accept4(listenFd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+            if (fd < 0)
+                return; // EAGAIN: no more pending connections
+
+            Connection connection;
+            connection.fd = fd;
+            connection.id = nextConnectionId++;
+            connection.busy = false;
+            connection.wantRead = true;
+            connection.wantWrite = false;
+            connections[fd] = connection;
+            connectionFds[connection.id] = fd;
+            watch(fd, EPOLLIN | EPOLLRDHUP);
+        }
+    }
+
+    void closeConnection(int fd)
+    {
+        std::map<int, Connection>::iterator it = connections.find(fd);
+        if (it == connections.end())
+            return;
+        epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, NULL);
+        close(fd);
+        connectionFds.erase(it->second.id);
+        connections.erase(it);
+    }
+
+    void handleConnectionEvent(int fd, uint32_t events)
+    {
+        std::map<int, Connection>::iterator it = connections.find(fd);
+        if (it == connections.end())
+            return;
+        Connection &connection = it->second;
+
+        if (events & EPOLLIN)
+        {
+            char chunk[SERVER_READ_CHUNK];
+            while (connection.input.size() < SERVER_MAX_INPUT)
+            {
+                ssize_t n = recv(fd, chunk, sizeof(chunk), 0);
+                if (n > 0)
+                {
+                    connection.input.append(chunk, static_cast<size_t>(n));
+                    continue;
+                }
+                if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+                    break;
+                if (n < 0 && errno == EINTR)
+                    continue;
+                closeConnection(fd); // EOF or hard error
+                return;
+            }
+            if (!processInput(connection))
+            {
+                closeConnection(fd);
+                return;
+            }
+            updateInterest(connection);
+        }
+        else if (events & (EPOLLHUP | EPOLLERR))
+        {
+            closeConnection(fd);
+            return;
+        }
+
+        if (events & EPOLLOUT)
+        {
+            if (!flushOutput(connection))
+                closeConnection(fd);
+        }
+    }
+
+    /**
+     * Dispatches the next complete request if nothing is in flight
+     * @return false if the peer sent a malformed frame
+     */
+    bool processInput(Connection &connection)
+    {
+        while (!connection.busy && connection.input.size() >= 4)
+        {
+            uint32_t length = decodeFrameLength(connection.input.data());
+            if (length == 0 || length > MAX_REQUEST_FRAME)
+                return false;
+            if (connection.input.size() < 4 + static_cast<size_t>(length))
+                return true; // Wait for the rest of the frame
+
+            std::string request = connection.input.substr(4, length);
+            connection.input.erase(0, 4 + static_cast<size_t>(length));
+
+            uint8_t opcode = static_cast<uint8_t>(request[0]);
+            if (opcode == OP_PING)
+            {
+                FrameWriter writer;
+                writer.begin(STATUS_OK);
+                queueOutput(connection, writer.finish());
+            }
+            else if (opcode == OP_ADD)
+            {
+                FrameReader reader(request.data() + 1, request.size() - 1);
+                PendingAdd add;
+                add.connectionId = connection.id;
+                add.date = reader.getDate();
+                add.cents = reader.getI64();
+                add.category = reader.getString();
+                add.description = reader.getString();
+                if (!reader.ok() || !reader.atEnd())
+                    return false;
+                if (!isValidDate(add.date))
+                {
+                    queueOutput(connection, errorFrame("Error: Invalid date format. Please use YYYY-MM-DD format."));
+                    continue;
+                }
+                if (add.cents <= 0)
+                {
+                    queueOutput(connection, errorFrame("Error: Amount must be positive."));
+                    continue;
+                }
+                connection.busy = true;
+                {
+                    std::lock_guard<std::mutex> guard(jobMutex);
+                    adds.push_back(add);
+                }
+                addReady.notify_one();
+            }
+            else if (opcode == OP_LIST_ALL || opcode == OP_FILTER_DATE ||
+                     opcode == OP_FILTER_CATEGORY || opcode == OP_SUMMARY || opcode == OP_RANGE_TOTAL)
+            {
+                connection.busy = true;
+                ReadJob job;
+                job.connectionId = connection.id;
+                job.request.swap(request);
+                {
+                    std::lock_guard<std::mutex> guard(jobMutex);
+                    jobs.push_back(job);
+                }
+                jobReady.notify_one();
+            }
+            else
+            {
+                return false; // Unknown opcode
+            }
+        }
+        return true;
+    }
+
+    void queueOutput(Connection &connection, const std::string &frame)
+    {
+        connection.output.append(frame);
+        if (!flushOutput(connection))
+            connection.output.clear(); // Peer is gone; EPOLLHUP will clean up
+    }
+
+    /**
+     * Writes as much queued output as the socket accepts
+     * @return false on a hard write error
+     */
+    bool flushOutput(Connection &connection)
+    {
+        while (!connection.output.empty())
+        {
+            ssize_t n = send(connection.fd, connection.output.data(), connection.output.size(), MSG_NOSIGNAL);
+            if (n > 0)
+            {
+                connection.output.erase(0, static_cast<size_t>(n));
+                continue;
+            }
+            if (n < 0 && errno == EINTR)
+                continue;
+            if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+                break;
+            return false;
+        }
+
+        updateInterest(connection);
+        return true;
+    }
+
+    /**
+     * Sends a finished response and lets the connection's next request run
+     */
+    void completeRequest(uint64_t connectionId, const std::string &frame)
+    {
+        std::map<uint64_t, int>::iterator fdIt = connectionFds.find(connectionId);
+        if (fdIt == connectionFds.end())
+            return; // Client disconnected while the request was running
+        Connection &connection = connections[fdIt->second];
+        connection.busy = false;
+        queueOutput(connection, frame);
+        if (!processInput(connection))
+            closeConnection(connection.fd);
+        else
+            updateInterest(connection); // Resume reading if input had filled up
+    }
+
+    /**
+     * Applies queued adds in batches; every add queued since the previous
+     * batch shares one writer lock
+     */
+    void writerLoop()
+    {
+        while (true)
+        {
+            std::vector<PendingAdd> batch;
+            {
+                std::unique_lock<std::mutex> guard(jobMutex);
+                while (adds.empty() && !workersStopping)
+                    addReady.wait(guard);
+                if (workersStopping)
+                    return;
+                batch.swap(adds);
+            }
+
+            std::vector<Reply> done(batch.size());
+            trackerLock.lockExclusive();
+            for (size_t i = 0; i < batch.size(); ++i)
+            {
+                const PendingAdd &add = batch[i];
+                std::string error;
+                done[i].connectionId = add.connectionId;
+                if (tracker.insertExpense(add.date, add.cents, add.category, add.description, error))
+                {
+                    FrameWriter writer;
+                    writer.begin(STATUS_OK);
+                    done[i].frame = writer.finish();
+                }
+                else
+                {
+                    done[i].frame = errorFrame(error);
+                }
+            }
+            std::string flushError;
+            if (!tracker.flushLedger(flushError))
+            {
+                logStream << flushError << "\n";
+            }
+            trackerLock.unlockExclusive();
+
+            {
+                std::lock_guard<std::mutex> guard(replyMutex);
+                replies.insert(replies.end(), done.begin(), done.end());
+            }
+            wakeEventLoop();
+        }
+    }
+
+    /**
+     * Prints the ledger problems the engine noticed while answering requests
+     */
+    void logWarnings()
+    {
+        std::vector<std::string> warnings;
+        tracker.takeWarnings(warnings);
+        for (size_t i = 0; i < warnings.size(); ++i)
+        {
+            logStream << warnings[i] << "\n";
+        }
+    }
+
+    /**
+     * Signals the event loop that replies or a stop request are ready
+     */
+    void wakeEventLoop()
+    {
+        uint64_t one = 1;
+        ssize_t ignored = write(wakeFd, &one, sizeof(one));
+        (void)ignored;
+    }
+
+    /**
+     * Drains replies produced by the worker and writer threads
+     */
+    void collectReplies()
+    {
+        uint64_t counter;
+        while (read(wakeFd, &counter, sizeof(counter)) > 0)
+        {
+        }
+
+        std::vector<Reply> ready;
+        {
+            std::lock_guard<std::mutex> guard(replyMutex);
+            ready.swap(replies);
+        }
+        for (size_t i = 0; i < ready.size(); ++i)
+        {
+            completeRequest(ready[i].connectionId, ready[i].frame);
+        }
+    }
+
+    void workerLoop()
+    {
+        while (true)
+        {
+            ReadJob job;
+            {
+                std::unique_lock<std::mutex> guard(jobMutex);
+                while (jobs.empty() && !workersStopping)
+                    jobReady.wait(guard);
+                if (workersStopping)
+                    return;
+                job = jobs.front();
+                jobs.pop_front();
+            }
+
+            Reply reply;
+            reply.connectionId = job.connectionId;
+            trackerLock.lockShared();
+            reply.frame = answerReadRequest(job.request);
+            trackerLock.unlockShared();
+
+            {
+                std::lock_guard<std::mutex> guard(replyMutex);
+                replies.push_back(reply);
+            }
+            wakeEventLoop();
+        }
+    }
+
+    /**
+     * Runs a list/filter/summary request against the tracker
+     * Called from worker threads while holding the reader lock
+     * @param request Frame body (opcode + payload)
+     * @return Complete response frame
+     */
+    std::string answerReadRequest(const std::string &request) const
+    {
+        uint8_t opcode = static_cast<uint8_t>(request[0]);
+        FrameReader reader(request.data() + 1, request.size() - 1);
+        FrameWriter writer;
+
+        if (opcode == OP_SUMMARY)
+        {
+            if (!reader.atEnd())
+                return errorFrame("Error: Malformed summary request.");
+            ExpenseSummary summary;
+            tracker.computeSummary(summary);
+            writer.begin(STATUS_OK);
+            writer.putU32(static_cast<uint32_t>(summary.categoryCount));
+            for (int i = 0; i < summary.categoryCount; ++i)
+            {
+                writer.putString(summary.categories[i]);
+                writer.putI64(summary.totalCents[i]);
+            }
+            writer.putI64(summary.totalExpensesCents);
+            return writer.finish();
+        }
+
+        int32_t startDay = 0, endDay = 0;
+        int categoryId = -1;
+        if (opcode == OP_RANGE_TOTAL)
+        {
+            if (!parseDayNumber(reader.getDate(), startDay) || !parseDayNumber(reader.getDate(), endDay))
+                return errorFrame("Error: Invalid date format. Please use YYYY-MM-DD format.");
+            if (startDay > endDay)
+                std::swap(startDay, endDay);
+            std::string category = reader.getString();
+            if (!reader.ok() || !reader.atEnd())
+                return errorFrame("Error: Malformed request.");
+
+            // Answered from the date-range index, never by scanning rows
+            ExpenseTotals totals = {0, 0};
+            if (category.empty())
+                totals = tracker.getRangeTotals(startDay, endDay);
+            else
+                totals = tracker.getRangeTotals(startDay, endDay, category);
+            writer.begin(STATUS_OK);
+            writer.putI64(totals.count);
+            writer.putI64(totals.totalCents);
+            return writer.finish();
+        }
+        if (opcode == OP_FILTER_DATE)
+        {
+            if (!parseDayNumber(reader.getDate(), startDay) || !parseDayNumber(reader.getDate(), endDay))
+                return errorFrame("Error: Invalid date format. Please use YYYY-MM-DD format.");
+            if (startDay > endDay)
+                std::swap(startDay, endDay);
+        }
+        else if (opcode == OP_FILTER_CATEGORY)
+        {
+            std::string category = reader.getString();
+            if (category.empty())
+                return errorFrame("Error: Category cannot be empty.");
+            categoryId = tracker.findCategory(category);
+        }
+        if (!reader.ok() || !reader.atEnd())
+            return errorFrame("Error: Malformed request.");
+
+        // Row count is patched in once the matching rows have been written
+        writer.begin(STATUS_OK);
+        writer.putU32(0);
+        uint32_t count = 0;
+        if (opcode == OP_FILTER_DATE)
+        {
+            // Range scans only touch ledger segments that overlap the range
+            tracker.forEachExpenseInRange(startDay, endDay, [&](const ExpenseRef &expense)
+            {
+                encodeExpenseRow(writer, expense);
+                count++;
+            });
+        }
+        else
+        {
+            tracker.forEachExpense([&](const ExpenseRef &expense)
+            {
+                if (opcode == OP_LIST_ALL || expense.categoryId == categoryId)
+                {
+                    encodeExpenseRow(writer, expense);
+                    count++;
+                }
+            });
+        }
+        std::string frame = writer.finish();
+        for (int i = 0; i < 4; ++i)
+            frame[5 + i] = static_cast<char>((count >> (8 * i)) & 0xFF);
+        return frame;
+    }
+
+    QueryServer(const QueryServer &);
+    QueryServer &operator=(const QueryServer &);
+};
+
+#endif // EXPENSE_SERVER_H
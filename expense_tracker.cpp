@@ -8,20 +8,14 @@
 #include <iomanip>
 #include <string>
 #include <limits>
-using namespace std;
+#include "expense_engine.h"
 
-// Structure to hold individual expense data
-struct Expense
-{
-    string date;        // Date in YYYY-MM-DD format
-    float amount;       // Expense amount (must be positive)
-    string category;    // Category of the expense (e.g., Food, Transport)
-    string description; // Brief description of the expense
-};
+#ifdef __linux__
+// Server mode (--serve) is built on epoll and Unix domain sockets
+#include "expense_server.h"
+#endif
 
-// Constants for array management
-const int INITIAL_CAPACITY = 10; // Starting size for dynamic array
-const int MAX_CATEGORIES = 50;   // Maximum number of unique categories
+using namespace std;
 
 // ============================================================================
 // UTILITY FUNCTIONS
@@ -69,17 +63,31 @@ void printSummary()
     cout << "\nCategory Breakdown" << endl;
 }
 
+/**
+ * Prints the ledger problems the engine noticed while answering queries
+ */
+void printEngineWarnings(ExpenseTracker &tracker)
+{
+    vector<string> warnings;
+    tracker.takeWarnings(warnings);
+    for (size_t i = 0; i < warnings.size(); ++i)
+    {
+        cout << warnings[i] << "\n";
+    }
+}
+
 // ============================================================================
 // INPUT VALIDATION FUNCTIONS
 // ============================================================================
 
 /**
  * Gets a valid positive amount from user input
- * @return Valid positive float amount
+ * @return Valid positive amount in cents (read as a double, so large
+ *         amounts keep their cents)
  */
-float getValidAmount()
+int64_t getValidAmount()
 {
-    float amount;
+    double amount;
     while (true)
     {
         cout << "Enter amount: ";
@@ -89,7 +97,7 @@ float getValidAmount()
             // Ensure amount is positive
             if (amount > 0)
             {
-                return amount;
+                return static_cast<int64_t>(llround(amount * 100.0));
             }
             else
             {
@@ -140,32 +148,6 @@ int getValidChoice(int min, int max)
     }
 }
 
-/**
- * Validates date format (YYYY-MM-DD)
- * @param date String to validate
- * @return true if date format is valid, false otherwise
- */
-bool isValidDate(const string &date)
-{
-    // Check length (YYYY-MM-DD = 10 characters)
-    if (date.length() != 10)
-        return false;
-
-    // Check for dashes in correct positions
-    if (date[4] != '-' || date[7] != '-')
-        return false;
-
-    // Check if year, month, day positions contain only digits
-    for (int i = 0; i < 10; i++)
-    {
-        if (i == 4 || i == 7)
-            continue; // Skip dash positions
-        if (!isdigit(date[i]))
-            return false;
-    }
-    return true;
-}
-
 /**
  * Gets a valid date from user input
  * @return Valid date string in YYYY-MM-DD format
@@ -184,335 +166,606 @@ string getValidDate()
         }
         else
         {
-            cout << "Error: Invalid date format. Please use YYYY-MM-DD format.\n";
+            cout << "Error: Invalid date. Please enter a real calendar date in YYYY-MM-DD format.\n";
         }
     }
 }
 
+/**
+ * Gets a valid date from user input as a day number
+ * @return Days since 1970-01-01
+ */
+int32_t getValidDay()
+{
+    int32_t day = 0;
+    parseDayNumber(getValidDate(), day);
+    return day;
+}
+
 // ============================================================================
-// EXPENSE TRACKER CLASS
+// CONSOLE VIEWS
 // ============================================================================
+//
+// The menu's screens, written against the engine's query API in
+// expense_engine.h. Listings stream ExpenseRef views straight to cout,
+// so large ledgers are printed without materializing a result set.
 
-class ExpenseTracker
+/**
+ * Adds a new expense and reports the outcome
+ * @param date Date of expense (YYYY-MM-DD format)
+ * @param cents Amount of expense in cents (positive value)
+ * @param category Category of expense
+ * @param description Description of expense
+ */
+void addExpenses(ExpenseTracker &tracker, const string &date, int64_t cents, const string &category,
+                 const string &description)
 {
-public:
-    /**
-     * Constructor - initializes the expense tracker with empty array
-     */
-    ExpenseTracker()
-    {
-        capacity = INITIAL_CAPACITY;
-        size = 0;
-        expenses = new Expense *[capacity]; // Dynamic array of pointers
-    }
-
-    /**
-     * Destructor - cleans up dynamically allocated memory
-     */
-    ~ExpenseTracker()
+    string error;
+    if (tracker.insertExpense(date, cents, category, description, error))
     {
-        // Free each allocated Expense object
-        for (int i = 0; i < size; ++i)
+        cout << "\nExpense added successfully!\n";
+        if (!tracker.flushLedger(error))
         {
-            delete expenses[i];
+            cout << error << "\n";
         }
-        // Free the array of pointers
-        delete[] expenses;
     }
+    else
+    {
+        cout << error << "\n";
+    }
+}
 
-    /**
-     * Adds a new expense to the tracker
-     * @param date Date of expense (YYYY-MM-DD format)
-     * @param amount Amount of expense (positive value)
-     * @param category Category of expense
-     * @param description Description of expense
-     */
-    void addExpenses(string date, float amount, string category, string description)
+/**
+ * Prints one expense row
+ * @param showCategory false when the listing is already for one category
+ */
+void printExpense(const ExpenseRef &expense, bool showCategory)
+{
+    char date[11];
+    formatDayNumber(expense.day, date);
+    cout << "Date: " << date
+         << ", Amount: $" << fixed << setprecision(2) << expense.amount();
+    if (showCategory)
     {
-        try
-        {
-            // Resize array if needed
-            if (size >= capacity)
-            {
-                resize();
-            }
+        cout << ", Category: " << *expense.category;
+    }
+    cout << ", Description: ";
+    cout.write(expense.description, expense.descriptionLength);
+    cout << endl;
+}
 
-            // Validate required inputs
-            if (category.empty())
-            {
-                cout << "Error: Category cannot be empty.\n";
-                return;
-            }
-            if (description.empty())
-            {
-                cout << "Error: Description cannot be empty.\n";
-                return;
-            }
+/**
+ * Asks how a listing should be ordered
+ * @param options Receives the chosen key and direction
+ * @return false to keep the order the expenses were added in
+ */
+bool getSortChoice(SortOptions &options)
+{
+    cout << "\nSort by:" << endl;
+    cout << "1. Order added" << endl;
+    cout << "2. Date" << endl;
+    cout << "3. Amount" << endl;
+    cout << "4. Category" << endl;
+    cout << "Enter sort choice (1-4): ";
+    int choice = getValidChoice(1, 4);
+    if (choice == 1)
+        return false;
+    options.key = static_cast<SortKey>(choice - 2);
 
-            // Create new expense and add to array
-            Expense *newExpense = new Expense{date, amount, category, description};
-            expenses[size++] = newExpense;
-            cout << "\nExpense added successfully!\n";
-        }
-        catch (const bad_alloc &e)
-        {
-            // Handle memory allocation failure
-            cout << "Error: Memory allocation failed. Cannot add expense.\n";
-        }
-        catch (const exception &e)
-        {
-            // Handle any other exceptions
-            cout << "Error adding expense: " << e.what() << "\n";
-        }
-    }
+    cout << "1. Ascending" << endl;
+    cout << "2. Descending" << endl;
+    cout << "Enter order (1-2): ";
+    options.descending = getValidChoice(1, 2) == 2;
+    return true;
+}
 
-    /**
-     * Displays expenses based on filter choice
-     * @param filterChoice 1=All, 2=Date range, 3=Category
-     */
-    void getExpenses(int filterChoice)
+/**
+ * Prints the expenses dated in [startDay, endDay], optionally for one category
+ * @param categoryId Category ID, or -1 for all categories
+ * @param sort Report order, or NULL for the order the expenses were added in
+ * @return true if at least one expense was printed
+ */
+bool listExpenses(const ExpenseTracker &tracker, int32_t startDay, int32_t endDay, int categoryId,
+                  bool showCategory, const SortOptions *sort)
+{
+    bool found = false;
+    auto print = [&](const ExpenseRef &expense)
     {
-        // Check if any expenses exist
-        if (size == 0)
-        {
-            noExpenseMessage();
-            return;
-        }
+        printExpense(expense, showCategory);
+        found = true;
+    };
 
-        // Route to appropriate filter function
-        switch (filterChoice)
+    if (sort == NULL)
+    {
+        tracker.forEachExpenseInRange(startDay, endDay, [&](const ExpenseRef &expense)
         {
-        case 1:
-            printAllExpenses();
-            break;
-        case 2:
-            filterByDateRange();
-            break;
-        case 3:
-            filterByCategory();
-            break;
-        default:
-            cout << "Invalid filter option.\n";
-        }
+            if (categoryId < 0 || expense.categoryId == categoryId)
+                print(expense);
+        });
+        return found;
     }
 
-    /**
-     * Displays summary of expenses grouped by category
-     */
-    void getSummary()
+    // Sorted listings stream through the engine's external sort
+    string error;
+    if (!tracker.forEachSorted(startDay, endDay, categoryId, *sort, print, error))
     {
-        // Check if any expenses exist
-        if (size == 0)
-        {
-            noExpenseMessage();
-            return;
-        }
-
-        printSummary();
-
-        // Arrays to store unique categories and their totals
-        string uniqueCategories[MAX_CATEGORIES];
-        float totals[MAX_CATEGORIES] = {0};
-        int categoryCount = 0;
-        float totalExpenses = 0.0f;
-
-        // Process each expense to calculate category totals
-        for (int i = 0; i < size; ++i)
-        {
-            bool found = false;
+        cout << error << "\n";
+    }
+    return found;
+}
 
-            // Check if category already exists
-            for (int j = 0; j < categoryCount; ++j)
-            {
-                if (expenses[i]->category == uniqueCategories[j])
-                {
-                    totals[j] += expenses[i]->amount;
-                    found = true;
-                    break;
-                }
-            }
+/**
+ * Prints all expenses without filtering
+ */
+void printAllExpenses(const ExpenseTracker &tracker, const SortOptions *sort)
+{
+    cout << "\n--- All Expenses ---\n";
+    listExpenses(tracker, numeric_limits<int32_t>::min(), numeric_limits<int32_t>::max(), -1, true, sort);
+}
 
-            // Add new category if not found
-            if (!found)
-            {
-                if (categoryCount < MAX_CATEGORIES)
-                {
-                    uniqueCategories[categoryCount] = expenses[i]->category;
-                    totals[categoryCount] = expenses[i]->amount;
-                    categoryCount++;
-                }
-                else
-                {
-                    cout << "Warning: Maximum categories exceeded. Some categories may not be displayed.\n";
-                }
-            }
+/**
+ * Filters and displays expenses within a date range
+ */
+void filterByDateRange(const ExpenseTracker &tracker, const SortOptions *sort)
+{
+    // Get valid start and end dates from user as day numbers
+    int32_t startDay = getValidDay();
+    int32_t endDay = getValidDay();
 
-            // Add to overall total
-            totalExpenses += expenses[i]->amount;
-        }
+    // Ensure start date is before end date
+    if (startDay > endDay)
+    {
+        cout << "Warning: Start date is after end date. Swapping dates.\n";
+        swap(startDay, endDay);
+    }
 
-        // Display category breakdown
-        for (int i = 0; i < categoryCount; ++i)
-        {
-            cout << " - " << uniqueCategories[i] << ": $" << fixed << setprecision(2) << totals[i] << endl;
-        }
+    char startDate[11], endDate[11];
+    formatDayNumber(startDay, startDate);
+    formatDayNumber(endDay, endDate);
+    cout << "\n--- Expenses from " << startDate << " to " << endDate << " ---\n";
 
-        // Display total expenses
-        cout << "\nTotal Expenses: $" << fixed << setprecision(2) << totalExpenses << endl;
+    // Inform user if no expenses found in range
+    if (!listExpenses(tracker, startDay, endDay, -1, true, sort))
+    {
+        cout << "No expenses found in the specified date range.\n";
     }
+}
 
-private:
-    // Member variables
-    Expense **expenses; // Dynamic array of pointers to Expense objects
-    int capacity;       // Current capacity of the array
-    int size;           // Current number of expenses stored
+/**
+ * Filters and displays expenses by category
+ */
+void filterByCategory(const ExpenseTracker &tracker, const SortOptions *sort)
+{
+    string categoryItem;
+    cout << "Enter category to filter by: ";
+    cin.ignore(); // Clear any leftover input from previous cin operations
+    getline(cin, categoryItem);
 
-    /**
-     * Doubles the capacity of the expenses array
-     * Called when array becomes full
-     */
-    void resize()
+    // Validate category input
+    if (categoryItem.empty())
     {
-        try
-        {
-            // Double the capacity
-            capacity *= 2;
+        cout << "Error: Category cannot be empty.\n";
+        return;
+    }
 
-            // Create new larger array
-            Expense **newArr = new Expense *[capacity];
+    cout << "\n--- Expenses in category: " << categoryItem << " ---\n";
 
-            // Copy existing pointers to new array
-            for (int i = 0; i < size; ++i)
-            {
-                newArr[i] = expenses[i];
-            }
+    // Match by interned category ID (case-sensitive); unknown names match nothing
+    int categoryId = tracker.findCategory(categoryItem);
+    bool found = categoryId >= 0 &&
+                 listExpenses(tracker, numeric_limits<int32_t>::min(), numeric_limits<int32_t>::max(),
+                              categoryId, false, sort);
 
-            // Delete old array and update pointer
-            delete[] expenses;
-            expenses = newArr;
-        }
-        catch (const bad_alloc &e)
-        {
-            // Handle memory allocation failure
-            cout << "Error: Memory allocation failed during resize.\n";
-            throw; // Re-throw to handle in calling function
-        }
+    // Inform user if no expenses found in category
+    if (!found)
+    {
+        cout << "No expenses found in category: " << categoryItem << "\n";
     }
+}
 
-    /**
-     * Prints all expenses without filtering
-     */
-    void printAllExpenses()
+/**
+ * Writes every expense in the chosen order, in the ledger row format
+ * (date <TAB> amount <TAB> category <TAB> description)
+ * @param path Output file, or "-" for standard output
+ * @return false if the report could not be written
+ */
+bool writeSortedReport(const ExpenseTracker &tracker, const string &path, const SortOptions &options)
+{
+    vector<char> buffer(1 << 20);
+    ofstream file;
+    if (path != "-")
     {
-        cout << "\n--- All Expenses ---\n";
-        for (int i = 0; i < size; ++i)
+        file.rdbuf()->pubsetbuf(&buffer[0], buffer.size());
+        file.open(path.c_str());
+        if (!file)
         {
-            cout << "Date: " << expenses[i]->date
-                 << ", Amount: $" << fixed << setprecision(2) << expenses[i]->amount
-                 << ", Category: " << expenses[i]->category
-                 << ", Description: " << expenses[i]->description << endl;
+            cout << "Error: Cannot write report file " << path << ".\n";
+            return false;
         }
     }
+    ostream &out = path == "-" ? cout : file;
 
-    /**
-     * Filters and displays expenses within a date range
-     */
-    void filterByDateRange()
+    string error;
+    string line;
+    long rows = 0;
+    bool ok = tracker.forEachSorted(numeric_limits<int32_t>::min(), numeric_limits<int32_t>::max(), -1, options,
+                                    [&](const ExpenseRef &expense)
+    {
+        line.clear();
+        appendLedgerRow(line, expense.day, expense.cents, *expense.category, expense.description,
+                        expense.descriptionLength);
+        out.write(line.data(), line.size());
+        rows++;
+    }, error);
+    out.flush();
+
+    if (!ok || !out)
+    {
+        cout << (ok ? "Error: Cannot write report file " + path + "." : error) << "\n";
+        return false;
+    }
+    if (path != "-")
     {
-        // Get valid start and end dates from user
-        string startDate = getValidDate();
-        string endDate = getValidDate();
+        cout << "Wrote " << rows << " expenses sorted by " << SORT_KEY_NAMES[options.key]
+             << (options.descending ? " (descending)" : "") << " to " << path << "\n";
+    }
+    return true;
+}
 
-        // Ensure start date is before end date (string comparison works for YYYY-MM-DD format)
-        if (startDate > endDate)
-        {
-            cout << "Warning: Start date is after end date. Swapping dates.\n";
-            swap(startDate, endDate);
-        }
+/**
+ * Displays the count and total of expenses in a date range, optionally for
+ * one category, using the engine's range-totals index
+ */
+void printRangeTotal(const ExpenseTracker &tracker)
+{
+    int32_t startDay = getValidDay();
+    int32_t endDay = getValidDay();
+    if (startDay > endDay)
+    {
+        cout << "Warning: Start date is after end date. Swapping dates.\n";
+        swap(startDay, endDay);
+    }
 
-        cout << "\n--- Expenses from " << startDate << " to " << endDate << " ---\n";
-        bool found = false;
+    string categoryItem;
+    cout << "Enter category (leave blank for all): ";
+    cin.ignore(); // Clear any leftover input from previous cin operations
+    getline(cin, categoryItem);
+
+    ExpenseTotals totals = categoryItem.empty() ? tracker.getRangeTotals(startDay, endDay)
+                                                : tracker.getRangeTotals(startDay, endDay, categoryItem);
+    char startDate[11], endDate[11];
+    formatDayNumber(startDay, startDate);
+    formatDayNumber(endDay, endDate);
+    cout << "\n--- Total from " << startDate << " to " << endDate;
+    if (!categoryItem.empty())
+    {
+        cout << " in category: " << categoryItem;
+    }
+    cout << " ---\n";
+    cout << "Expenses: " << totals.count << "\n";
+    cout << "Total:    $" << formatCents(totals.totalCents) << "\n";
+}
 
-        // Check each expense against date range (string comparison works for YYYY-MM-DD format)
-        for (int i = 0; i < size; ++i)
-        {
-            if (expenses[i]->date >= startDate && expenses[i]->date <= endDate)
-            {
-                cout << "Date: " << expenses[i]->date
-                     << ", Amount: $" << fixed << setprecision(2) << expenses[i]->amount
-                     << ", Category: " << expenses[i]->category
-                     << ", Description: " << expenses[i]->description << endl;
-                found = true;
-            }
-        }
+/**
+ * Displays expenses based on filter choice
+ * @param filterChoice 1=All, 2=Date range, 3=Category
+ * @param sortDefaults Memory budget and spill directory for sorted listings
+ */
+void getExpenses(const ExpenseTracker &tracker, int filterChoice, const SortOptions &sortDefaults)
+{
+    // Check if any expenses exist
+    if (tracker.getCount() == 0)
+    {
+        noExpenseMessage();
+        return;
+    }
 
-        // Inform user if no expenses found in range
-        if (!found)
-        {
-            cout << "No expenses found in the specified date range.\n";
-        }
+    SortOptions sortOptions = sortDefaults;
+    const SortOptions *sort = getSortChoice(sortOptions) ? &sortOptions : NULL;
+
+    // Route to appropriate filter function
+    switch (filterChoice)
+    {
+    case 1:
+        printAllExpenses(tracker, sort);
+        break;
+    case 2:
+        filterByDateRange(tracker, sort);
+        break;
+    case 3:
+        filterByCategory(tracker, sort);
+        break;
+    default:
+        cout << "Invalid filter option.\n";
     }
+}
 
-    /**
-     * Filters and displays expenses by category
-     */
-    void filterByCategory()
+/**
+ * Displays summary of expenses grouped by category
+ */
+void getSummary(const ExpenseTracker &tracker)
+{
+    // Check if any expenses exist
+    if (tracker.getCount() == 0)
     {
-        string categoryItem;
-        cout << "Enter category to filter by: ";
-        cin.ignore(); // Clear any leftover input from previous cin operations
-        getline(cin, categoryItem);
+        noExpenseMessage();
+        return;
+    }
 
-        // Validate category input
-        if (categoryItem.empty())
-        {
-            cout << "Error: Category cannot be empty.\n";
-            return;
-        }
+    printSummary();
 
-        cout << "\n--- Expenses in category: " << categoryItem << " ---\n";
-        bool found = false;
+    ExpenseSummary summary;
+    tracker.computeSummary(summary);
+    if (summary.overflow)
+    {
+        cout << "Warning: Maximum categories exceeded. Some categories may not be displayed.\n";
+    }
 
-        // Check each expense for matching category (case-sensitive comparison)
-        for (int i = 0; i < size; ++i)
-        {
-            if (expenses[i]->category == categoryItem)
-            {
-                cout << "Date: " << expenses[i]->date
-                     << ", Amount: $" << fixed << setprecision(2) << expenses[i]->amount
-                     << ", Description: " << expenses[i]->description << endl;
-                found = true;
-            }
-        }
+    // Display category breakdown
+    for (int i = 0; i < summary.categoryCount; ++i)
+    {
+        cout << " - " << summary.categories[i] << ": $" << fixed << setprecision(2) << summary.totalCents[i] / 100.0 << endl;
+    }
 
-        // Inform user if no expenses found in category
-        if (!found)
-        {
-            cout << "No expenses found in category: " << categoryItem << "\n";
-        }
+    // Display total expenses
+    cout << "\nTotal Expenses: $" << fixed << setprecision(2) << summary.totalExpensesCents / 100.0 << endl;
+}
+
+/**
+ * Displays how much memory the stored rows use
+ */
+void printMemoryReport(const ExpenseTracker &tracker)
+{
+    MemoryReport report;
+    tracker.getMemoryReport(report);
+
+    size_t storageBytes = report.rowBytes + report.poolBytes + report.poolIndexBytes;
+    size_t totalBytes = storageBytes + report.categoryBytes;
+
+    cout << "\n--- Memory Report ---\n";
+    cout << "Rows in memory:        " << report.rows << "\n";
+    cout << "Fixed row size:        " << sizeof(CompactExpense) << " bytes (date, amount, category ID, description offset/length)\n";
+    cout << "Row arrays:            " << report.rowBytes << " bytes (including spare capacity)\n";
+    cout << "Description pool:      " << report.poolBytes << " bytes for " << report.uniqueDescriptions << " unique descriptions\n";
+    cout << "Description index:     " << report.poolIndexBytes << " bytes\n";
+    cout << "Category table:        " << report.categoryBytes << " bytes for " << report.categoryCount << " categories\n";
+    cout << "Total:                 " << totalBytes << " bytes\n";
+    if (report.rows > 0)
+    {
+        cout << "Bytes per row:         " << fixed << setprecision(1)
+             << static_cast<double>(storageBytes) / report.rows << " (all storage)\n";
+    }
+    if (report.rangeIndexBytes > 0)
+    {
+        cout << "Range totals index:    " << report.rangeIndexBytes << " bytes\n";
+    }
+    if (report.segmentCount > 0)
+    {
+        cout << "Ledger segments:       " << report.loadedSegments << " of " << report.segmentCount
+             << " loaded (cap " << report.memoryCap / (1024 * 1024) << " MB)\n";
+    }
+}
+
+/**
+ * Displays the outcome of a bulk import
+ */
+void printImportReport(const ImportReport &report)
+{
+    cout << "\n--- Import Report ---\n";
+    cout << "Rows read:             " << report.rowsRead << "\n";
+    cout << "Imported:              " << report.imported << "\n";
+    cout << "Skipped duplicates:    " << report.duplicates << "\n";
+    cout << "Malformed rows:        " << report.malformed << "\n";
+    for (size_t i = 0; i < report.duplicateRows.size(); ++i)
+    {
+        cout << "  duplicate " << report.duplicateRows[i] << "\n";
     }
-};
+    if (report.duplicates > static_cast<long>(report.duplicateRows.size()))
+    {
+        cout << "  ... and " << report.duplicates - static_cast<long>(report.duplicateRows.size()) << " more\n";
+    }
+}
+
+/**
+ * Imports a file and prints the report
+ * @return false if the import failed
+ */
+bool runImport(ExpenseTracker &tracker, const string &path)
+{
+    ImportReport report;
+    string error;
+    bool ok = tracker.importExpenses(path, report, error);
+    printImportReport(report);
+    if (!ok)
+        cout << error << "\n";
+    return ok;
+}
 
 // ============================================================================
 // MAIN FUNCTION
 // ============================================================================
 
+/**
+ * Prints command-line usage
+ */
+void printUsage(const char *program)
+{
+    cout << "Usage: " << program << " [options]\n"
+         << "  (no options)          Run the interactive menu\n"
+         << "  --serve SOCKET        Serve add/filter/summary requests on a Unix domain socket\n"
+         << "  --workers N           Reader threads used by --serve (default: CPU count)\n"
+         << "  --ledger MANIFEST     Use an on-disk ledger; month segments load on first use\n"
+         << "  --memory-cap MB       Memory for loaded ledger segments (default: "
+         << DEFAULT_LEDGER_MEMORY_CAP_MB << ")\n"
+         << "  --rules FILE          Budget/threshold alert rules checked on every add\n"
+         << "  --alerts FILE         Append alerts to FILE instead of printing them\n"
+         << "  --import FILE         Import ledger-format rows from FILE, then exit (or serve)\n"
+         << "  --dedup               Skip imported rows that match a stored row\n"
+         << "  --dedup-window DAYS   Days of history checked by --dedup (default: "
+         << DEFAULT_DEDUP_WINDOW_DAYS << ", 0 = all)\n"
+         << "  --report FILE         Write every expense, sorted, to FILE ('-' = stdout), then exit (or serve)\n"
+         << "  --sort KEY            Report order: date, amount or category (default: date)\n"
+         << "  --descending          Sort the report in descending order\n"
+         << "  --sort-memory MB      Memory for sorting before spilling runs to disk (default: "
+         << DEFAULT_SORT_MEMORY_MB << ")\n"
+         << "  --sort-dir DIR        Directory for sort run files (default: current directory)\n";
+}
+
 /**
  * Main program entry point
  * Handles the main menu loop and user interactions
  */
-int main()
+int main(int argc, char *argv[])
 {
-    // Display welcome banner
-    printBanner();
+    string socketPath;
+    string ledgerPath;
+    size_t memoryCapMb = DEFAULT_LEDGER_MEMORY_CAP_MB;
+    string rulesPath;
+    string alertsPath;
+    int workerCount = 0;
+    string importPath;
+    string reportPath;
+    SortOptions sortOptions;
+    bool dedup = false;
+    int dedupWindowDays = DEFAULT_DEDUP_WINDOW_DAYS;
+
+    // Parse command-line options
+    for (int i = 1; i < argc; ++i)
+    {
+        string option = argv[i];
+        if (option == "--serve" && i + 1 < argc)
+        {
+            socketPath = argv[++i];
+        }
+        else if (option == "--workers" && i + 1 < argc)
+        {
+            workerCount = atoi(argv[++i]);
+        }
+        else if (option == "--ledger" && i + 1 < argc)
+        {
+            ledgerPath = argv[++i];
+        }
+        else if (option == "--memory-cap" && i + 1 < argc && atoi(argv[i + 1]) > 0)
+        {
+            memoryCapMb = static_cast<size_t>(atoi(argv[++i]));
+        }
+        else if (option == "--rules" && i + 1 < argc)
+        {
+            rulesPath = argv[++i];
+        }
+        else if (option == "--alerts" && i + 1 < argc)
+        {
+            alertsPath = argv[++i];
+        }
+        else if (option == "--import" && i + 1 < argc)
+        {
+            importPath = argv[++i];
+        }
+        else if (option == "--dedup")
+        {
+            dedup = true;
+        }
+        else if (option == "--report" && i + 1 < argc)
+        {
+            reportPath = argv[++i];
+        }
+        else if (option == "--sort" && i + 1 < argc && parseSortKey(argv[i + 1], sortOptions.key))
+        {
+            ++i;
+        }
+        else if (option == "--descending")
+        {
+            sortOptions.descending = true;
+        }
+        else if (option == "--sort-memory" && i + 1 < argc && atoi(argv[i + 1]) > 0)
+        {
+            sortOptions.memoryBudget = static_cast<size_t>(atoi(argv[++i])) * 1024 * 1024;
+        }
+        else if (option == "--sort-dir" && i + 1 < argc)
+        {
+            sortOptions.spillDirectory = argv[++i];
+        }
+        else if (option == "--dedup-window" && i + 1 < argc && atoi(argv[i + 1]) >= 0)
+        {
+            dedup = true;
+            dedupWindowDays = atoi(argv[++i]);
+        }
+        else
+        {
+            printUsage(argv[0]);
+            return option == "--help" ? 0 : 1;
+        }
+    }
 
     // Create expense tracker instance
     ExpenseTracker et;
+    if (!ledgerPath.empty())
+    {
+        string error;
+        if (!et.openLedger(ledgerPath, memoryCapMb * 1024 * 1024, error))
+        {
+            cout << error << "\n";
+            return 1;
+        }
+    }
+    if (!rulesPath.empty())
+    {
+        string error;
+        if (!et.loadAlertRules(rulesPath, error) ||
+            (!alertsPath.empty() && !et.setAlertOutput(alertsPath, error)))
+        {
+            cout << error << "\n";
+            return 1;
+        }
+        if (alertsPath.empty())
+        {
+            et.setAlertOutput(cout);
+        }
+    }
+    if (dedup)
+    {
+        et.enableDuplicateDetection(dedupWindowDays);
+    }
+    if (!importPath.empty() && !runImport(et, importPath))
+    {
+        printEngineWarnings(et);
+        return 1;
+    }
+    if (!reportPath.empty() && !writeSortedReport(et, reportPath, sortOptions))
+    {
+        printEngineWarnings(et);
+        return 1;
+    }
+    printEngineWarnings(et);
+    if ((!importPath.empty() || !reportPath.empty()) && socketPath.empty())
+    {
+        return 0; // Batch run: no menu
+    }
+
+    if (!socketPath.empty())
+    {
+#ifdef __linux__
+        if (workerCount <= 0)
+        {
+            workerCount = static_cast<int>(thread::hardware_concurrency());
+            if (workerCount < 2)
+                workerCount = 2;
+        }
+        QueryServer server(et, socketPath, workerCount, cout);
+        return server.run();
+#else
+        cout << "Error: Server mode is only available on Linux.\n";
+        return 1;
+#endif
+    }
+
+    // Display welcome banner
+    printBanner();
 
     // Variables for user input
     int choice;
     string date;
-    float amount;
+    int64_t cents;
     string category;
     string description;
     int filterChoice;
@@ -525,24 +778,27 @@ int main()
         cout << "1. Add Expense" << endl;
         cout << "2. View Expenses" << endl;
         cout << "3. Get Summary" << endl;
-        cout << "4. Exit" << endl;
+        cout << "4. Memory Report" << endl;
+        cout << "5. Import Expenses" << endl;
+        cout << "6. Total for Date Range" << endl;
+        cout << "7. Exit" << endl;
 
         // Get user's menu choice
-        cout << "\nEnter your choice (1-4): ";
-        choice = getValidChoice(1, 4);
+        cout << "\nEnter your choice (1-7): ";
+        choice = getValidChoice(1, 7);
 
         // Process user's choice
         switch (choice)
         {
         case 1: // Add new expense
             date = getValidDate();
-            amount = getValidAmount();
+            cents = getValidAmount();
             cin.ignore(); // Clear input buffer before getline
             cout << "Enter category: ";
             getline(cin, category);
             cout << "Enter description: ";
             getline(cin, description);
-            et.addExpenses(date, amount, category, description);
+            addExpenses(et, date, cents, category, description);
             break;
 
         case 2: // View expenses with filtering options
@@ -552,20 +808,43 @@ int main()
             cout << "3. Filter by category" << endl;
             cout << "Enter filter choice (1-3): ";
             filterChoice = getValidChoice(1, 3);
-            et.getExpenses(filterChoice);
+            getExpenses(et, filterChoice, sortOptions);
             break;
 
         case 3: // Display expense summary
-            et.getSummary();
+            getSummary(et);
+            break;
+
+        case 4: // Display storage statistics
+            printMemoryReport(et);
+            break;
+
+        case 5: // Bulk import from a file
+            cin.ignore(); // Clear input buffer before getline
+            cout << "Enter file to import: ";
+            getline(cin, importPath);
+            runImport(et, importPath);
+            break;
+
+        case 6: // Count and total for a date range
+            printRangeTotal(et);
             break;
 
-        case 4: // Exit program
+        case 7: // Exit program
+        {
+            string error;
+            if (!et.flushLedger(error))
+            {
+                cout << error << "\n";
+            }
             cout << "Thanks for using Expense Tracker!" << endl;
             cout << "Goodbye!" << endl;
             return 0;
+        }
 
         default: // Should never reach here due to input validation
             cout << "Invalid choice! Please try again." << endl;
         }
+        printEngineWarnings(et);
     }
 }
\ No newline at end of file
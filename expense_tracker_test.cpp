@@ -8,115 +8,102 @@
 #include <cassert>
 #include <string>
 #include <iomanip>
+#include "expense_engine.h"
+#ifdef __linux__
+#include <sys/socket.h>
+#include <sys/time.h>
+#include "expense_server.h"
+#endif
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#include <unistd.h>
+#include <dirent.h>
+#endif
 using namespace std;
 
-// Copy necessary structures and functions for testing
-struct Expense
+// Thin wrappers over the engine's query API, used by the tests below
+bool addExpense(ExpenseTracker &tracker, const string &date, float amount, const string &category, const string &description)
 {
-    string date;
-    float amount;
-    string category;
-    string description;
-};
+    string error;
+    return tracker.insertExpense(date, amount, category, description, error);
+}
 
-// Copy of isValidDate function from main code
-bool isValidDate(const string &date)
+float getTotalAmount(const ExpenseTracker &tracker)
 {
-    if (date.length() != 10)
-        return false;
-    if (date[4] != '-' || date[7] != '-')
-        return false;
-    for (int i = 0; i < 10; i++)
-    {
-        if (i == 4 || i == 7)
-            continue;
-        if (!isdigit(date[i]))
-            return false;
-    }
-    return true;
+    return tracker.selectAll().totals().totalCents / 100.0f;
 }
 
-// Simplified ExpenseTracker for testing
-class TestableExpenseTracker
+int countByCategory(const ExpenseTracker &tracker, const string &category)
 {
-private:
-    Expense **expenses;
-    int capacity;
-    int size;
-
-    void resize()
-    {
-        capacity *= 2;
-        Expense **newArr = new Expense *[capacity];
-        for (int i = 0; i < size; ++i)
-        {
-            newArr[i] = expenses[i];
-        }
-        delete[] expenses;
-        expenses = newArr;
-    }
-
-public:
-    TestableExpenseTracker() : capacity(10), size(0)
-    {
-        expenses = new Expense *[capacity];
-    }
+    return static_cast<int>(tracker.selectCategory(category).size());
+}
 
-    ~TestableExpenseTracker()
-    {
-        for (int i = 0; i < size; ++i)
-        {
-            delete expenses[i];
-        }
-        delete[] expenses;
-    }
+int countByDateRange(const ExpenseTracker &tracker, const string &startDate, const string &endDate)
+{
+    int32_t startDay, endDay;
+    if (!parseDayNumber(startDate, startDay) || !parseDayNumber(endDate, endDay))
+        return -1;
+    return static_cast<int>(tracker.selectDateRange(startDay, endDay).size());
+}
 
-    bool addExpense(const string &date, float amount, const string &category, const string &description)
-    {
-        if (!isValidDate(date) || amount <= 0 || category.empty() || description.empty())
-            return false;
+// Ledger and sort tests work in scratch directories next to the test binary
+const char *const TEST_LEDGER_DIR = "expense_tracker_test_ledger";
+const char *const TEST_LEDGER_MANIFEST = "expense_tracker_test_ledger/ledger.manifest";
+const char *const TEST_SORT_DIR = "expense_tracker_test_runs";
 
-        if (size >= capacity)
-            resize();
+void makeTestDir(const char *path)
+{
+#ifdef _WIN32
+    _mkdir(path);
+#else
+    mkdir(path, 0755);
+#endif
+}
 
-        expenses[size++] = new Expense{date, amount, category, description};
-        return true;
-    }
+void removeTestDir(const char *path)
+{
+#ifdef _WIN32
+    _rmdir(path);
+#else
+    rmdir(path);
+#endif
+}
 
-    int getSize() const { return size; }
+void makeTestLedgerDir()
+{
+    makeTestDir(TEST_LEDGER_DIR);
+}
 
-    float getTotalAmount() const
+/**
+ * Deletes the scratch ledger: its manifest and the month files named
+ */
+void removeTestLedgerDir(const vector<string> &months)
+{
+    string directory = string(TEST_LEDGER_DIR) + "/";
+    remove(TEST_LEDGER_MANIFEST);
+    for (size_t i = 0; i < months.size(); ++i)
     {
-        float total = 0.0f;
-        for (int i = 0; i < size; ++i)
-        {
-            total += expenses[i]->amount;
-        }
-        return total;
-    }
-
-    int countByCategory(const string &category) const
-    {
-        int count = 0;
-        for (int i = 0; i < size; ++i)
-        {
-            if (expenses[i]->category == category)
-                count++;
-        }
-        return count;
+        remove((directory + months[i] + ".tsv").c_str());
     }
+    removeTestDir(TEST_LEDGER_DIR);
+}
 
-    int countByDateRange(const string &startDate, const string &endDate) const
+/**
+ * @return Number of lines in a text file (0 if it cannot be read)
+ */
+int countLines(const char *path)
+{
+    ifstream file(path);
+    string line;
+    int lines = 0;
+    while (getline(file, line))
     {
-        int count = 0;
-        for (int i = 0; i < size; ++i)
-        {
-            if (expenses[i]->date >= startDate && expenses[i]->date <= endDate)
-                count++;
-        }
-        return count;
+        lines++;
     }
-};
+    return lines;
+}
 
 // Simple test helpers
 int tests_run = 0;
@@ -165,97 +152,938 @@ void test_date_validation()
     test_assert(!isValidDate("2025-5-1"), "Missing zeros rejected");
     test_assert(!isValidDate("invalid"), "Non-date string rejected");
     test_assert(!isValidDate(""), "Empty string rejected");
+    test_assert(!isValidDate("2024-13-45"), "Out-of-range month and day rejected");
+    test_assert(!isValidDate("2025-04-31") && !isValidDate("2025-06-00"), "Day outside the month rejected");
+    test_assert(isValidDate("2024-02-29") && !isValidDate("2023-02-29"), "Leap day only in leap years");
+    test_assert(isValidDate("2000-02-29") && !isValidDate("1900-02-29"), "Century leap rule applied");
+    test_assert(!isValidDate("2025-05-1.") && !isValidDate("2025-1.-10") && !isValidDate("-025-05-15") &&
+                    !isValidDate("2025-05-1*") && !isValidDate("2025-05-1/") && !isValidDate("2025-05-1:"),
+                "Punctuation next to the digits rejected");
+}
+
+void test_day_numbers()
+{
+    cout << "\n--- Day Number Tests ---" << endl;
+
+    int32_t day = -1;
+    test_assert(parseDayNumber("1970-01-01", day) && day == 0, "Epoch is day 0");
+    test_assert(parseDayNumber("1969-12-31", day) && day == -1, "Days before the epoch are negative");
+    test_assert(parseDayNumber("2024-03-01", day) && day == daysFromCivil(2024, 3, 1), "Day number matches civil conversion");
+
+    // Batched conversion round-trips every day of 1896-2104 and rejects
+    // calendar-invalid fields
+    int32_t firstDay = daysFromCivil(1896, 1, 1);
+    vector<string> dates;
+    char text[11];
+    for (int32_t d = firstDay; d <= daysFromCivil(2104, 12, 31); ++d)
+    {
+        formatDayNumber(d, text);
+        dates.push_back(text);
+    }
+    size_t realDates = dates.size();
+    dates.push_back("2023-02-29");
+    dates.push_back("2025-00-10");
+    dates.push_back("2025-1a-10");
+    dates.push_back("2025-05-1.");
+    dates.push_back("2025-1.-10");
+    dates.push_back("-025-05-15");
+    vector<const char *> fields;
+    for (size_t i = 0; i < dates.size(); ++i)
+    {
+        fields.push_back(dates[i].data());
+    }
+    vector<int32_t> days(dates.size());
+    vector<uint8_t> valid(dates.size());
+    bool same = parseDateFields(&fields[0], fields.size(), &days[0], &valid[0]) == realDates;
+    for (size_t i = 0; i < realDates && same; ++i)
+    {
+        same = valid[i] && days[i] == firstDay + static_cast<int32_t>(i);
+    }
+    test_assert(same, "Batched conversion round-trips day numbers");
+
+    // Calendar-invalid rows are rejected on import instead of being stored
+    const char *path = "expense_tracker_test_dates.tsv";
+    {
+        ofstream file(path);
+        file << "2024-02-29\t5.00\tFood\tLeap lunch\n"
+             << "2023-02-29\t5.00\tFood\tNo such day\n"
+             << "2024-13-45\t5.00\tFood\tNo such month\n"
+             << "2025-05-1.\t5.00\tFood\tPunctuated day\n";
+    }
+    ExpenseTracker tracker;
+    ImportReport report;
+    string error;
+    bool ok = tracker.importExpenses(path, report, error);
+    test_assert(ok && report.imported == 1 && report.malformed == 3, "Import rejects invalid calendar dates");
+    remove(path);
 }
 
 void test_basic_operations()
 {
     cout << "\n--- Basic Operations Tests ---" << endl;
 
-    TestableExpenseTracker tracker;
+    ExpenseTracker tracker;
 
-    test_assert(tracker.getSize() == 0, "Empty tracker initialization");
-    test_float_equal(0.0f, tracker.getTotalAmount(), "Empty tracker total");
+    test_assert(tracker.getCount() == 0, "Empty tracker initialization");
+    test_float_equal(0.0f, getTotalAmount(tracker), "Empty tracker total");
 
-    test_assert(tracker.addExpense("2025-05-01", 15.99f, "Food", "Lunch"), "Add valid expense");
-    test_assert(tracker.getSize() == 1, "Size after adding expense");
-    test_float_equal(15.99f, tracker.getTotalAmount(), "Total after adding expense");
+    test_assert(addExpense(tracker, "2025-05-01", 15.99f, "Food", "Lunch"), "Add valid expense");
+    test_assert(tracker.getCount() == 1, "Size after adding expense");
+    test_float_equal(15.99f, getTotalAmount(tracker), "Total after adding expense");
 }
 
 void test_invalid_inputs()
 {
     cout << "\n--- Invalid Input Tests ---" << endl;
 
-    TestableExpenseTracker tracker;
+    ExpenseTracker tracker;
 
-    test_assert(!tracker.addExpense("invalid-date", 10.0f, "Test", "Test"), "Reject invalid date");
-    test_assert(!tracker.addExpense("2025-05-01", -5.0f, "Test", "Test"), "Reject negative amount");
-    test_assert(!tracker.addExpense("2025-05-01", 10.0f, "", "Test"), "Reject empty category");
-    test_assert(!tracker.addExpense("2025-05-01", 10.0f, "Test", ""), "Reject empty description");
-    test_assert(tracker.getSize() == 0, "No invalid expenses added");
+    test_assert(!addExpense(tracker, "invalid-date", 10.0f, "Test", "Test"), "Reject invalid date");
+    test_assert(!addExpense(tracker, "2025-05-01", -5.0f, "Test", "Test"), "Reject negative amount");
+    test_assert(!addExpense(tracker, "2025-05-01", 10.0f, "", "Test"), "Reject empty category");
+    test_assert(!addExpense(tracker, "2025-05-01", 10.0f, "Test", ""), "Reject empty description");
+    test_assert(tracker.getCount() == 0, "No invalid expenses added");
 }
 
 void test_filtering()
 {
     cout << "\n--- Filtering Tests ---" << endl;
 
-    TestableExpenseTracker tracker;
+    ExpenseTracker tracker;
 
     // Add test data
-    tracker.addExpense("2025-05-01", 15.99f, "Food", "Lunch");
-    tracker.addExpense("2025-05-02", 50.00f, "Transport", "Gas");
-    tracker.addExpense("2025-05-03", 25.50f, "Food", "Dinner");
-    tracker.addExpense("2025-05-05", 100.00f, "Entertainment", "Concert");
+    addExpense(tracker, "2025-05-01", 15.99f, "Food", "Lunch");
+    addExpense(tracker, "2025-05-02", 50.00f, "Transport", "Gas");
+    addExpense(tracker, "2025-05-03", 25.50f, "Food", "Dinner");
+    addExpense(tracker, "2025-05-05", 100.00f, "Entertainment", "Concert");
 
-    test_assert(tracker.countByCategory("Food") == 2, "Filter by Food category");
-    test_assert(tracker.countByCategory("Transport") == 1, "Filter by Transport category");
-    test_assert(tracker.countByCategory("NonExistent") == 0, "Filter by non-existent category");
+    test_assert(countByCategory(tracker, "Food") == 2, "Filter by Food category");
+    test_assert(countByCategory(tracker, "Transport") == 1, "Filter by Transport category");
+    test_assert(countByCategory(tracker, "NonExistent") == 0, "Filter by non-existent category");
 
-    test_assert(tracker.countByDateRange("2025-05-01", "2025-05-03") == 3, "Date range filter (inclusive)");
-    test_assert(tracker.countByDateRange("2025-05-02", "2025-05-04") == 2, "Date range filter (partial)");
-    test_assert(tracker.countByDateRange("2025-05-06", "2025-05-07") == 0, "Date range filter (no matches)");
+    test_assert(countByDateRange(tracker, "2025-05-01", "2025-05-03") == 3, "Date range filter (inclusive)");
+    test_assert(countByDateRange(tracker, "2025-05-02", "2025-05-04") == 2, "Date range filter (partial)");
+    test_assert(countByDateRange(tracker, "2025-05-06", "2025-05-07") == 0, "Date range filter (no matches)");
 }
 
 void test_memory_management()
 {
     cout << "\n--- Memory Management Tests ---" << endl;
 
-    TestableExpenseTracker tracker;
+    ExpenseTracker tracker;
 
     // Test dynamic resizing by adding more than initial capacity
     for (int i = 1; i <= 15; ++i)
     {
         string date = "2025-05-" + (i < 10 ? "0" + to_string(i) : to_string(i));
-        tracker.addExpense(date, 10.0f, "Test", "Test expense");
+        addExpense(tracker, date, 10.0f, "Test", "Test expense");
     }
 
-    test_assert(tracker.getSize() == 15, "Dynamic array resize handling");
-    test_float_equal(150.0f, tracker.getTotalAmount(), "Data integrity after resize");
+    test_assert(tracker.getCount() == 15, "Dynamic array resize handling");
+    test_float_equal(150.0f, getTotalAmount(tracker), "Data integrity after resize");
 }
 
 void test_edge_cases()
 {
     cout << "\n--- Edge Case Tests ---" << endl;
 
-    TestableExpenseTracker tracker;
+    ExpenseTracker tracker;
+
+    test_assert(addExpense(tracker, "2025-01-01", 0.01f, "Test", "Min amount"), "Minimum positive amount");
+    test_assert(addExpense(tracker, "2025-12-31", 9999.99f, "Test", "Large amount"), "Large amount handling");
+    test_assert(addExpense(tracker, "2025-05-01", 10.0f, "A", "B"), "Single character strings");
 
-    test_assert(tracker.addExpense("2025-01-01", 0.01f, "Test", "Min amount"), "Minimum positive amount");
-    test_assert(tracker.addExpense("2025-12-31", 9999.99f, "Test", "Large amount"), "Large amount handling");
-    test_assert(tracker.addExpense("2025-05-01", 10.0f, "A", "B"), "Single character strings");
+    // Amounts given in cents are stored exactly, beyond float precision
+    ExpenseTracker exact;
+    string error;
+    test_assert(exact.insertExpense("2025-05-01", static_cast<int64_t>(100000001), "Big", "House", error) &&
+                    exact.selectAll().totals().totalCents == 100000001,
+                "Amount in cents stored exactly");
+    test_assert(!exact.insertExpense("2025-05-01", static_cast<int64_t>(MAX_AMOUNT_CENTS) + 1, "Big", "Too much", error),
+                "Amount over the row limit rejected");
 }
 
 void test_integration()
 {
     cout << "\n--- Integration Test ---" << endl;
 
-    TestableExpenseTracker tracker;
+    ExpenseTracker tracker;
 
     // Complete workflow test
-    tracker.addExpense("2025-05-01", 15.99f, "Food", "Lunch");
-    tracker.addExpense("2025-05-02", 50.00f, "Transport", "Gas");
+    addExpense(tracker, "2025-05-01", 15.99f, "Food", "Lunch");
+    addExpense(tracker, "2025-05-02", 50.00f, "Transport", "Gas");
+
+    test_assert(tracker.getCount() == 2, "Integration: expense count");
+    test_assert(countByCategory(tracker, "Food") == 1, "Integration: category filtering");
+    test_float_equal(65.99f, getTotalAmount(tracker), "Integration: total calculation");
+}
+
+void test_query_api()
+{
+    cout << "\n--- Query API Tests ---" << endl;
+
+    ExpenseTracker tracker;
+    addExpense(tracker, "2025-05-01", 15.99f, "Food", "Lunch");
+    addExpense(tracker, "2025-05-02", 50.00f, "Transport", "Gas");
+    addExpense(tracker, "2025-05-03", 25.50f, "Food", "Dinner");
+
+    ExpenseSelection food = tracker.selectCategory("Food");
+    test_assert(food.size() == 2 && food.rowIds()[0].row == 0 && food.rowIds()[1].row == 2, "Selection holds row IDs");
+
+    ExpenseRef first = food[0];
+    test_assert(*first.category == "Food" && string(first.description, first.descriptionLength) == "Lunch",
+                "Row view resolves stored fields");
+    test_assert(first.category == food[1].category, "Views share interned category strings");
+
+    int64_t iterated = 0;
+    for (ExpenseSelection::const_iterator it = food.begin(); it != food.end(); ++it)
+    {
+        iterated += (*it).cents;
+    }
+    ExpenseTotals totals = food.totals();
+    test_assert(iterated == 4149 && totals.count == 2 && totals.totalCents == 4149, "Iterator and totals agree");
+
+    test_assert(tracker.selectCategory("Missing").empty(), "Unknown category selects nothing");
+
+    ExpenseSummary summary;
+    tracker.computeSummary(summary);
+    test_assert(summary.categoryCount == 2 && summary.totalExpensesCents == 9149, "Summary aggregates in cents");
+}
+
+void test_compact_storage()
+{
+    cout << "\n--- Compact Storage Tests ---" << endl;
+
+    // Repeated descriptions share one copy in the pool; the report's bytes
+    // per row (spare capacity included) stays under 24 at every size checked
+    ExpenseTracker tracker;
+    string error;
+    MemoryReport report;
+    const char *descriptions[] = {"Coffee", "Lunch at restaurant", "Monthly bus pass", "Coffee"};
+    double worstBytesPerRow = 0;
+    for (int i = 1; i <= 100000; ++i)
+    {
+        tracker.insertExpense("2025-05-01", static_cast<int64_t>(100 + i % 500), i % 2 == 0 ? "Food" : "Transport",
+                              descriptions[i % 4], error);
+        if (i >= 10000 && i % 1000 == 0)
+        {
+            tracker.getMemoryReport(report);
+            size_t storageBytes = report.rowBytes + report.poolBytes + report.poolIndexBytes;
+            worstBytesPerRow = max(worstBytesPerRow, static_cast<double>(storageBytes) / report.rows);
+        }
+    }
+    test_assert(report.rows == 100000 && report.uniqueDescriptions == 3, "Duplicate descriptions stored once");
+    test_assert(report.poolBytes <= 1024, "Description pool holds only the distinct bytes");
+    test_assert(worstBytesPerRow < 24.0, "Storage under 24 bytes per row");
+    test_assert(report.categoryCount == 2, "Categories interned once");
+
+    // Descriptions beyond the 16-bit length are truncated, not rejected
+    ExpenseTracker longTracker;
+    string longDescription(MAX_DESCRIPTION_LENGTH + 100, 'x');
+    longDescription[MAX_DESCRIPTION_LENGTH - 1] = 'y';
+    bool added = longTracker.insertExpense("2025-05-01", static_cast<int64_t>(100), "Food", longDescription, error);
+    ExpenseRef stored = longTracker.selectAll()[0];
+    test_assert(added && stored.descriptionLength == MAX_DESCRIPTION_LENGTH && stored.description[MAX_DESCRIPTION_LENGTH - 1] == 'y',
+                "Long description truncated to 65535 bytes");
+}
+
+void test_duplicate_import()
+{
+    cout << "\n--- Duplicate Import Tests ---" << endl;
+
+    const char *path = "expense_tracker_test_import.tsv";
+    {
+        ofstream file(path);
+        file << "2025-06-01\t3.50\tFood\tCoffee\n"
+             << "2025-06-01\t3.50\tFood\t  coffee \n"
+             << "2025-06-02\t12.00\tFood\tBagels\n"
+             << "not a row\n";
+    }
+
+    ExpenseTracker tracker;
+    addExpense(tracker, "2025-06-01", 3.50f, "Food", "Coffee");
+    tracker.enableDuplicateDetection(DEFAULT_DEDUP_WINDOW_DAYS);
+
+    ImportReport report;
+    string error;
+    bool ok = tracker.importExpenses(path, report, error);
+    test_assert(ok && report.rowsRead == 4 && report.malformed == 1, "Import counts rows and malformed lines");
+    test_assert(report.duplicates == 1 && report.imported == 2, "Only rows already stored are skipped");
+    test_assert(report.duplicateRows.size() == 1 && report.duplicateRows[0].find("line 1:") == 0, "Skipped row reported");
+
+    ok = tracker.importExpenses(path, report, error);
+    test_assert(ok && report.duplicates == 3 && report.imported == 0, "Re-import skips every stored row");
+    test_assert(tracker.getCount() == 3, "No duplicates stored");
+
+    // Rows older than the lookback window are not checked
+    {
+        ofstream file(path);
+        file << "2025-06-01\t3.50\tFood\tCoffee\n"
+             << "2025-09-01\t9.00\tFood\tLunch\n";
+    }
+    ExpenseTracker windowed;
+    addExpense(windowed, "2025-06-01", 3.50f, "Food", "Coffee");
+    addExpense(windowed, "2025-09-01", 9.00f, "Food", "Lunch");
+    windowed.enableDuplicateDetection(30);
+    ok = windowed.importExpenses(path, report, error);
+    test_assert(ok && report.imported == 1 && report.duplicates == 1, "Lookback window limits duplicate checks");
+
+    // Detection seeds from rows already in a ledger
+    makeTestLedgerDir();
+    {
+        ExpenseTracker ledgerTracker;
+        ledgerTracker.openLedger(TEST_LEDGER_MANIFEST, 1 << 20, error);
+        addExpense(ledgerTracker, "2025-09-01", 9.00f, "Food", "Lunch");
+    }
+    {
+        ExpenseTracker ledgerTracker;
+        ledgerTracker.openLedger(TEST_LEDGER_MANIFEST, 1, error);
+        ledgerTracker.enableDuplicateDetection(DEFAULT_DEDUP_WINDOW_DAYS);
+        ok = ledgerTracker.importExpenses(path, report, error);
+        test_assert(ok && report.imported == 1 && report.duplicates == 1, "Ledger rows seed duplicate detection");
+    }
+    remove(path);
+    vector<string> months;
+    months.push_back("2025-06");
+    months.push_back("2025-09");
+    removeTestLedgerDir(months);
+}
+
+void test_lazy_ledger()
+{
+    cout << "\n--- Lazy Ledger Tests ---" << endl;
+
+    makeTestLedgerDir();
+    vector<string> months;
+    string error;
+    {
+        // A one-byte cap leaves only the month being written in memory
+        ExpenseTracker tracker;
+        tracker.openLedger(TEST_LEDGER_MANIFEST, 1, error);
+        char date[11];
+        for (int month = 1; month <= 6; ++month)
+        {
+            snprintf(date, sizeof(date), "2025-%02d-15", month);
+            months.push_back(string(date).substr(0, 7));
+            addExpense(tracker, date, 10.00f, "Rent", "Monthly");
+            addExpense(tracker, date, 2.50f, "Food", "Lunch");
+        }
+        MemoryReport report;
+        tracker.getMemoryReport(report);
+        test_assert(report.segmentCount == 6 && report.loadedSegments == 1, "Appends evict months over the memory cap");
+        test_assert(tracker.selectAll().size() == 12 && getTotalAmount(tracker) == 75.0f, "Evicted months reload for queries");
+    }
+
+    // Reopening reads only the manifest; queries load just the months they touch
+    {
+        ExpenseTracker tracker;
+        MemoryReport report;
+        bool opened = tracker.openLedger(TEST_LEDGER_MANIFEST, 1 << 20, error);
+        tracker.getMemoryReport(report);
+        test_assert(opened && tracker.getCount() == 12 && report.segmentCount == 6 && report.loadedSegments == 0,
+                    "Opening a ledger reads only the manifest");
+
+        int march = countByDateRange(tracker, "2025-03-01", "2025-03-31");
+        tracker.getMemoryReport(report);
+        test_assert(march == 2 && report.loadedSegments == 1, "Date-range query skips months outside the range");
+
+        ExpenseSelection spring = tracker.selectDateRange(daysFromCivil(2025, 3, 1), daysFromCivil(2025, 5, 31));
+        tracker.getMemoryReport(report);
+        test_assert(spring.size() == 6 && report.loadedSegments == 3, "Selection loads every overlapping month");
+    }
+    {
+        ExpenseTracker tracker;
+        MemoryReport report;
+        tracker.openLedger(TEST_LEDGER_MANIFEST, 1, error);
+        int rows = 0;
+        tracker.forEachExpense([&](const ExpenseRef &) { rows++; });
+        tracker.getMemoryReport(report);
+        test_assert(rows == 12 && report.loadedSegments == 0, "Months loaded by a scan are evicted over the cap");
+    }
+
+    // Manifest errors: a malformed line fails the open, a missing manifest starts a new ledger
+    const char *badManifest = "expense_tracker_test_ledger/bad.manifest";
+    {
+        ofstream manifest(badManifest);
+        manifest << LEDGER_MANIFEST_HEADER << "\n"
+                 << "2025-01\t2025-01.tsv\tmany\t2025-01-15\t2025-01-15\n";
+    }
+    {
+        ExpenseTracker tracker;
+        bool opened = tracker.openLedger(badManifest, 1 << 20, error);
+        test_assert(!opened && error.find("line 2") != string::npos, "Malformed manifest line rejected");
+    }
+    remove(badManifest);
+    {
+        ExpenseTracker tracker;
+        bool opened = tracker.openLedger("expense_tracker_test_ledger/new.manifest", 1 << 20, error);
+        test_assert(opened && tracker.getCount() == 0, "Missing manifest starts an empty ledger");
+    }
+    remove("expense_tracker_test_ledger/new.manifest");
+
+    // A month whose file disappeared is skipped and reported as a warning
+    remove((string(TEST_LEDGER_DIR) + "/2025-03.tsv").c_str());
+    {
+        ExpenseTracker tracker;
+        tracker.openLedger(TEST_LEDGER_MANIFEST, 1 << 20, error);
+        vector<string> warnings;
+        int rows = static_cast<int>(tracker.selectAll().size());
+        tracker.takeWarnings(warnings);
+        test_assert(rows == 10 && warnings.size() == 1 && warnings[0].find("2025-03.tsv") != string::npos,
+                    "Unreadable month reported through takeWarnings");
+        warnings.clear();
+        tracker.takeWarnings(warnings);
+        test_assert(warnings.empty(), "Warnings are collected once");
+    }
+
+    // Creating an earlier month while a selection is alive must not shift its pins
+    {
+        ExpenseTracker tracker;
+        MemoryReport report;
+        tracker.openLedger(TEST_LEDGER_MANIFEST, 1, error);
+        {
+            ExpenseSelection may = tracker.selectDateRange(daysFromCivil(2025, 5, 1), daysFromCivil(2025, 5, 31));
+            addExpense(tracker, "2024-12-24", 40.00f, "Gifts", "Presents");
+            test_assert(may.size() == 2 && may.totals().totalCents == 1250 && may[0].day == daysFromCivil(2025, 5, 15),
+                        "Selection rows unchanged after an earlier month is created");
+        }
+        tracker.getMemoryReport(report);
+        test_assert(report.segmentCount == 7 && report.loadedSegments == 0,
+                    "Dropped selection unpins its own months");
+    }
+    months.push_back("2024-12");
+    removeTestLedgerDir(months);
+}
+
+void test_ledger_import_alerts()
+{
+    cout << "\n--- Ledger Import With Alerts Tests ---" << endl;
+
+    makeTestLedgerDir();
+    const char *rulesPath = "expense_tracker_test_rules.txt";
+    const char *alertsPath = "expense_tracker_test_alerts.txt";
+    const char *importPath = "expense_tracker_test_ledger_import.tsv";
+    string error;
+    {
+        ExpenseTracker tracker;
+        tracker.openLedger(TEST_LEDGER_MANIFEST, 1 << 20, error);
+        addExpense(tracker, "2025-05-02", 30.00f, "Food", "Groceries");
+    }
+    {
+        ofstream rules(rulesPath);
+        rules << "budget Food month 100\n";
+        ofstream file(importPath);
+        file << "2025-05-10\t50.00\tFood\tDinner\n"
+             << "2025-05-11\t50.00\tFood\tDinner\n"
+             << "2025-05-12\t5.00\tFood\tSnack\n";
+    }
+    remove(alertsPath);
+
+    // The month is cold when the import starts, so seeding the budget loads
+    // it while the import still holds the month's file open
+    {
+        ExpenseTracker tracker;
+        ImportReport report;
+        bool ok = tracker.openLedger(TEST_LEDGER_MANIFEST, 1 << 20, error) && tracker.loadAlertRules(rulesPath, error) &&
+                  tracker.setAlertOutput(alertsPath, error) && tracker.importExpenses(importPath, report, error);
+        test_assert(ok && report.imported == 3, "Import into a ledger with budget rules");
+        ExpenseTotals totals = tracker.getRangeTotals(daysFromCivil(2025, 5, 1), daysFromCivil(2025, 5, 31));
+        test_assert(totals.count == 4 && totals.totalCents == 13500, "Loaded month includes rows written during the import");
+    }
+    test_assert(countLines(alertsPath) == 1, "Budget alert fires once when the import crosses it");
+
+    ExpenseTracker reopened;
+    reopened.openLedger(TEST_LEDGER_MANIFEST, 1 << 20, error);
+    test_assert(reopened.getCount() == 4, "Manifest row count matches the data file");
+
+    remove(rulesPath);
+    remove(alertsPath);
+    remove(importPath);
+    removeTestLedgerDir(vector<string>(1, "2025-05"));
+}
+
+void test_alert_rules()
+{
+    cout << "\n--- Alert Rule Tests ---" << endl;
+
+    const char *rulesPath = "expense_tracker_test_rules.txt";
+    const char *alertsPath = "expense_tracker_test_alerts.txt";
+    string error;
+
+    // A bad period or a trailing token is rejected with its line number
+    {
+        ofstream rules(rulesPath);
+        rules << "# thresholds\n"
+              << "single Food 40\n"
+              << "budget Food fortnight 100\n";
+    }
+    {
+        ExpenseTracker tracker;
+        bool loaded = tracker.loadAlertRules(rulesPath, error);
+        test_assert(!loaded && error.find("line 3") != string::npos, "Malformed budget rule rejected");
+    }
+    {
+        ofstream rules(rulesPath);
+        rules << "single * 40 extra\n";
+    }
+    {
+        ExpenseTracker tracker;
+        bool loaded = tracker.loadAlertRules(rulesPath, error);
+        test_assert(!loaded && error.find("line 1") != string::npos, "Rule with a trailing token rejected");
+    }
+
+    // Single rules fire per expense; a budget fires only on the crossing insert
+    {
+        ofstream rules(rulesPath);
+        rules << "single \"Eating Out\" 40   # quoted category\n"
+              << "budget * month 100\n";
+    }
+    remove(alertsPath);
+    {
+        ExpenseTracker tracker;
+        bool ok = tracker.loadAlertRules(rulesPath, error) && tracker.setAlertOutput(alertsPath, error);
+        test_assert(ok, "Single and budget rules parsed");
+        addExpense(tracker, "2025-04-01", 45.00f, "Eating Out", "Dinner");
+        addExpense(tracker, "2025-04-02", 45.00f, "Food", "Groceries");
+        addExpense(tracker, "2025-04-03", 10.00f, "Food", "Snacks");
+    }
+    test_assert(countLines(alertsPath) == 1, "Single rule fires only in its category");
+    {
+        ExpenseTracker tracker;
+        tracker.loadAlertRules(rulesPath, error);
+        tracker.setAlertOutput(alertsPath, error);
+        addExpense(tracker, "2025-04-01", 60.00f, "Food", "Groceries");
+        addExpense(tracker, "2025-04-02", 40.00f, "Food", "Groceries");
+        addExpense(tracker, "2025-04-03", 0.01f, "Food", "Gum");
+        addExpense(tracker, "2025-04-04", 20.00f, "Food", "Groceries");
+        addExpense(tracker, "2025-05-01", 150.00f, "Food", "Groceries");
+    }
+    test_assert(countLines(alertsPath) == 3, "Budget fires once per period when crossed");
+
+    // After a restart the month's total is seeded from the ledger's rows
+    {
+        ofstream rules(rulesPath);
+        rules << "budget Food month 100\n";
+    }
+    remove(alertsPath);
+    makeTestLedgerDir();
+    {
+        ExpenseTracker tracker;
+        tracker.openLedger(TEST_LEDGER_MANIFEST, 1 << 20, error);
+        addExpense(tracker, "2025-06-01", 60.00f, "Food", "Groceries");
+        addExpense(tracker, "2025-06-02", 30.00f, "Food", "Groceries");
+    }
+    {
+        ExpenseTracker tracker;
+        bool ok = tracker.openLedger(TEST_LEDGER_MANIFEST, 1 << 20, error) && tracker.loadAlertRules(rulesPath, error) &&
+                  tracker.setAlertOutput(alertsPath, error);
+        addExpense(tracker, "2025-06-20", 15.00f, "Food", "Groceries");
+        addExpense(tracker, "2025-06-21", 15.00f, "Food", "Groceries");
+        test_assert(ok, "Rules loaded over an existing ledger");
+    }
+    test_assert(countLines(alertsPath) == 1, "Budget seeded from stored rows after a restart");
+
+    // Rows stored after the rules never trigger a seeding pass over stored rows
+    {
+        ofstream rules(rulesPath);
+        rules << "budget * day 100\n"
+              << "budget Food month 1000\n";
+    }
+    remove(alertsPath);
+    {
+        ExpenseTracker tracker;
+        tracker.loadAlertRules(rulesPath, error);
+        tracker.setAlertOutput(alertsPath, error);
+        for (int i = 0; i < 3000; ++i)
+        {
+            tracker.insertExpense(dayNumberToDate(daysFromCivil(2020, 1, 1) + i / 3), static_cast<int64_t>(4000),
+                                  "Food", "Groceries", error);
+        }
+        MemoryReport report;
+        tracker.getMemoryReport(report);
+        test_assert(report.rangeIndexBytes == 0, "Fresh rules seed nothing from stored rows");
+    }
+    test_assert(countLines(alertsPath) == 1000 + 33, "Day and month budgets fire once per period");
+
+    // Ingest with a day budget stays within a small factor of ingest without rules
+    {
+        const int rows = 200000;
+        double seconds[2];
+        for (int withRules = 0; withRules < 2; ++withRules)
+        {
+            ExpenseTracker tracker;
+            if (withRules)
+                tracker.loadAlertRules(rulesPath, error);
+            chrono::steady_clock::time_point start = chrono::steady_clock::now();
+            for (int i = 0; i < rows; ++i)
+            {
+                string date = dayNumberToDate(daysFromCivil(2015, 1, 1) + i / (rows / 3650)); // Ten years, in order
+                tracker.insertExpense(date, static_cast<int64_t>(100), "Food", "Groceries", error);
+            }
+            seconds[withRules] = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        }
+        test_assert(seconds[1] < 4 * seconds[0] + 0.05, "Budget rules do not rescan stored rows per period");
+    }
+
+    // Rows stored before the rules are counted through the date-range index
+    remove(alertsPath);
+    {
+        ExpenseTracker tracker;
+        for (int i = 0; i < 1000; ++i)
+        {
+            tracker.insertExpense(dayNumberToDate(daysFromCivil(2020, 1, 1) + i), static_cast<int64_t>(9000),
+                                  i % 2 == 0 ? "Food" : "Rent", "Before rules", error);
+        }
+        tracker.loadAlertRules(rulesPath, error);
+        tracker.setAlertOutput(alertsPath, error);
+        for (int i = 0; i < 1000; ++i)
+        {
+            tracker.insertExpense(dayNumberToDate(daysFromCivil(2020, 1, 1) + i), static_cast<int64_t>(2000),
+                                  "Food", "After rules", error);
+        }
+    }
+    test_assert(countLines(alertsPath) == 1000, "Existing rows seed every period");
+
+    remove(rulesPath);
+    remove(alertsPath);
+    removeTestLedgerDir(vector<string>(1, "2025-06"));
+}
+
+void test_range_totals()
+{
+    cout << "\n--- Date-Range Totals Tests ---" << endl;
+
+    ExpenseTracker tracker;
+    addExpense(tracker, "2025-05-01", 15.99f, "Food", "Lunch");
+    addExpense(tracker, "2025-05-02", 50.00f, "Transport", "Gas");
+    addExpense(tracker, "2025-05-03", 25.50f, "Food", "Dinner");
+
+    int32_t may1, may2, may3;
+    parseDayNumber("2025-05-01", may1);
+    parseDayNumber("2025-05-02", may2);
+    parseDayNumber("2025-05-03", may3);
+    ExpenseTotals all = tracker.getRangeTotals(may1, may3);
+    test_assert(all.count == 3 && all.totalCents == 9149, "Range total over all categories");
+    ExpenseTotals food = tracker.getRangeTotals(may2, may3, "Food");
+    test_assert(food.count == 1 && food.totalCents == 2550, "Range total for one category");
+    test_assert(tracker.getRangeTotals(may1, may3, "Missing").count == 0, "Unknown category totals zero");
+
+    // Inserts after the index exists, out of order and far outside its initial span
+    addExpense(tracker, "1969-12-31", 1.00f, "Food", "Snack");
+    addExpense(tracker, "2031-01-15", 2.00f, "Food", "Snack");
+    addExpense(tracker, "2025-04-30", 3.00f, "Transport", "Bus");
+    test_assert(tracker.getRangeTotals(may1, may3).totalCents == 9149, "Existing ranges unchanged after growth");
+
+    // Compare random windows against a full scan
+    bool matches = true;
+    uint32_t state = 12345;
+    for (int i = 0; i < 300; ++i)
+    {
+        state = state * 1103515245u + 12345u;
+        int32_t start = may1 - 25000 + static_cast<int32_t>(state % 50000);
+        state = state * 1103515245u + 12345u;
+        int32_t end = start + static_cast<int32_t>(state % 30000);
+        int categoryId = (i % 3 == 0) ? -1 : tracker.findCategory(i % 3 == 1 ? "Food" : "Transport");
+
+        ExpenseTotals expected = {0, 0};
+        tracker.forEachExpenseInRange(start, end, [&](const ExpenseRef &expense)
+        {
+            if (categoryId < 0 || expense.categoryId == categoryId)
+            {
+                expected.count++;
+                expected.totalCents += expense.cents;
+            }
+        });
+        ExpenseTotals actual = tracker.getRangeTotals(start, end, categoryId);
+        matches = matches && actual.count == expected.count && actual.totalCents == expected.totalCents;
+    }
+    test_assert(matches, "Index matches a full scan for random windows");
+    ExpenseTotals everything = tracker.getRangeTotals(numeric_limits<int32_t>::min(), numeric_limits<int32_t>::max());
+    test_assert(everything.count == 6 && everything.totalCents == 9749, "Unbounded range covers every row");
+
+    // Far-apart dates cost a month block each, not the span between them
+    ExpenseTracker sparse;
+    sparse.getRangeTotals(may1, may3);
+    for (int i = 0; i < 20; ++i)
+    {
+        string category = "Category " + to_string(i);
+        addExpense(sparse, "2025-05-01", 1.00f, category, "Typical");
+        addExpense(sparse, i % 2 == 0 ? "0025-05-01" : "9999-12-31", 1.00f, category, "Typo");
+    }
+    MemoryReport report;
+    sparse.getMemoryReport(report);
+    test_assert(report.rangeIndexBytes < 64 * 1024, "Range index memory independent of the date span");
+    test_assert(sparse.getRangeTotals(may1, may3).count == 20 &&
+                sparse.getRangeTotals(numeric_limits<int32_t>::min(), numeric_limits<int32_t>::max(), "Category 3").count == 2,
+                "Far-apart dates totalled correctly");
+}
+
+void test_sorted_views()
+{
+    cout << "\n--- Sorted View Tests ---" << endl;
+
+    ExpenseTracker tracker;
+    addExpense(tracker, "2025-05-03", 25.50f, "Food", "Dinner");
+    addExpense(tracker, "2025-05-01", 50.00f, "Transport", "Gas");
+    addExpense(tracker, "2025-05-02", 15.99f, "Food", "Lunch");
+    addExpense(tracker, "2025-05-01", 25.50f, "Entertainment", "Movie");
+
+    ExpenseSelection all = tracker.selectAll();
+    tracker.sortSelection(all, SORT_BY_AMOUNT, true);
+    test_assert(all[0].cents == 5000 && all[3].cents == 1599, "Selection sorted by amount descending");
+    test_assert(all.rowIds()[1].row == 0 && all.rowIds()[2].row == 3, "Equal amounts keep their order");
+
+    tracker.sortSelection(all, SORT_BY_CATEGORY, false);
+    test_assert(*all[0].category == "Entertainment" && *all[3].category == "Transport", "Selection sorted by category");
+
+    tracker.sortSelection(all, SORT_BY_DATE, false);
+    test_assert(all.rowIds()[0].row == 3 && all.rowIds()[1].row == 1 && all.rowIds()[3].row == 0,
+                "Date sort keeps the category order for equal dates");
+
+    // Enough rows, and a small enough budget, to spill runs and merge them in several passes
+    for (int i = 0; i < 300; ++i)
+    {
+        char date[11];
+        snprintf(date, sizeof(date), "2024-%02d-%02d", i % 12 + 1, i % 28 + 1);
+        addExpense(tracker, date, static_cast<float>((i * 7919) % 500 + 1), i % 2 ? "Food" : "Rent", "Bulk row");
+    }
+    SortOptions options;
+    options.key = SORT_BY_AMOUNT;
+    options.memoryBudget = 64; // Every row becomes its own run
+    vector<int32_t> external;
+    string error;
+    bool ok = tracker.forEachSorted(numeric_limits<int32_t>::min(), numeric_limits<int32_t>::max(), -1, options,
+                                    [&](const ExpenseRef &expense) { external.push_back(expense.cents); }, error);
+
+    ExpenseSelection reference = tracker.selectAll();
+    tracker.sortSelection(reference, SORT_BY_AMOUNT, false);
+    bool same = ok && external.size() == reference.size();
+    for (size_t i = 0; same && i < external.size(); ++i)
+    {
+        same = external[i] == reference[i].cents;
+    }
+    test_assert(same, "External merge sort matches in-memory sort");
+
+    int food = 0;
+    options.memoryBudget = DEFAULT_SORT_MEMORY_MB * 1024 * 1024;
+    tracker.forEachSorted(numeric_limits<int32_t>::min(), numeric_limits<int32_t>::max(), tracker.findCategory("Food"),
+                          options, [&](const ExpenseRef &) { food++; }, error);
+    test_assert(food == 152, "Sorted view limited to one category");
+
+#ifndef _WIN32
+    // A run file cut short on disk fails the sort instead of dropping rows
+    makeTestDir(TEST_SORT_DIR);
+    options.memoryBudget = 64;
+    options.spillDirectory = TEST_SORT_DIR;
+    {
+        CategoryTable categories;
+        ExpenseSorter sorter(categories, options);
+        ExpenseRef row;
+        row.categoryId = categories.intern("Food");
+        row.category = &categories.getName(row.categoryId);
+        row.description = "Bulk row";
+        row.descriptionLength = 8;
+        const size_t rowCount = 200;
+        for (size_t i = 0; i < rowCount; ++i)
+        {
+            row.day = static_cast<int32_t>(i);
+            row.cents = static_cast<int32_t>((i * 7919) % 500 + 1);
+            sorter.add(row, error);
+        }
+        DIR *directory = opendir(TEST_SORT_DIR);
+        for (dirent *entry = readdir(directory); entry != NULL; entry = readdir(directory))
+        {
+            string name = entry->d_name;
+            if (name.size() > 4 && name.compare(name.size() - 4, 4, ".run") == 0)
+            {
+                string path = string(TEST_SORT_DIR) + "/" + name;
+                string bytes;
+                {
+                    ifstream run(path.c_str(), ios::binary);
+                    bytes.assign(istreambuf_iterator<char>(run), istreambuf_iterator<char>());
+                }
+                ofstream(path.c_str(), ios::binary | ios::trunc).write(bytes.data(), bytes.size() - 3);
+                break;
+            }
+        }
+        closedir(directory);
+
+        size_t emitted = 0;
+        error.clear();
+        ok = sorter.finish([&](const ExpenseRef &) { emitted++; }, error);
+        test_assert(!ok && error.find("truncated") != string::npos && emitted < rowCount,
+                    "Truncated sort run reported as an error");
+    }
+    removeTestDir(TEST_SORT_DIR);
+#endif
+}
+
+#ifdef __linux__
+/**
+ * Connects to a test server, retrying while it starts up
+ * @return Connected descriptor with a receive timeout, or -1
+ */
+int connectToTestServer(const char *path)
+{
+    for (int attempt = 0; attempt < 200; ++attempt)
+    {
+        int fd = connectToDaemon(path);
+        if (fd >= 0)
+        {
+            timeval timeout = {2, 0};
+            setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+            return fd;
+        }
+        this_thread::sleep_for(chrono::milliseconds(10));
+    }
+    return -1;
+}
+
+string addFrame(const string &date, int64_t cents, const string &category, const string &description)
+{
+    FrameWriter writer;
+    writer.begin(OP_ADD);
+    writer.putDate(date);
+    writer.putI64(cents);
+    writer.putString(category);
+    writer.putString(description);
+    return writer.finish();
+}
+
+/**
+ * @return Status byte of the next response, or -1 if none arrived
+ */
+int receiveStatus(int fd, string &body)
+{
+    if (!receiveFrame(fd, body))
+        return -1;
+    return static_cast<uint8_t>(body[0]);
+}
+#endif
+
+void test_protocol_frames()
+{
+    cout << "\n--- Protocol Frame Tests ---" << endl;
+#ifdef __linux__
+    FrameWriter writer;
+    writer.begin(OP_ADD);
+    writer.putDate("2025-05-01");
+    writer.putI64(-123456789012LL);
+    writer.putString("Food");
+    writer.putString(string(70000, 'x'));
+    string frame = writer.finish();
+    test_assert(decodeFrameLength(frame.data()) == frame.size() - 4, "Length prefix covers the frame body");
+
+    FrameReader reader(frame.data() + 4, frame.size() - 4);
+    uint8_t opcode = reader.getU8();
+    string date = reader.getDate();
+    int64_t cents = reader.getI64();
+    string category = reader.getString();
+    string description = reader.getString();
+    test_assert(reader.ok() && reader.atEnd() && opcode == OP_ADD && date == "2025-05-01" &&
+                    cents == -123456789012LL && category == "Food",
+                "Frame round trip");
+    test_assert(description.size() == MAX_WIRE_STRING, "Long string truncated to the u16 limit");
+    string largest = addFrame("2025-05-01", 1, string(70000, 'c'), string(70000, 'd'));
+    test_assert(largest.size() - 4 == MAX_REQUEST_FRAME, "Largest add fills MAX_REQUEST_FRAME exactly");
+
+    // Reads past the end fail without touching memory beyond the frame
+    FrameReader shortReader(frame.data() + 4, 1 + DATE_WIRE_LENGTH + 3);
+    shortReader.getU8();
+    shortReader.getDate();
+    int64_t partial = shortReader.getI64();
+    test_assert(!shortReader.ok() && partial == 0, "Read past the end clears ok()");
+    test_assert(shortReader.getString().empty() && !shortReader.ok(), "Reader stays failed after an overrun");
+
+    const char claimsMore[] = {5, 0, 'a', 'b'};
+    FrameReader stringReader(claimsMore, sizeof(claimsMore));
+    test_assert(stringReader.getString().empty() && !stringReader.ok(), "String longer than the frame rejected");
+
+    // A response length beyond MAX_RESPONSE_FRAME is refused before reading the body
+    int pair[2];
+    bool refused = false;
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, pair) == 0)
+    {
+        uint32_t length = MAX_RESPONSE_FRAME + 1;
+        string header;
+        for (int i = 0; i < 4; ++i)
+            header.push_back(static_cast<char>((length >> (8 * i)) & 0xFF));
+        string body;
+        refused = sendAll(pair[1], header) && !receiveFrame(pair[0], body);
+        close(pair[0]);
+        close(pair[1]);
+    }
+    test_assert(refused, "Oversized response length prefix refused");
+#endif
+}
+
+void test_query_server()
+{
+    cout << "\n--- Query Server Tests ---" << endl;
+#ifdef __linux__
+    const char *socketPath = "expense_tracker_test.sock";
+    ExpenseTracker tracker;
+    ostringstream serverLog;
+    QueryServer server(tracker, socketPath, 2, serverLog);
+    thread runner([&server]() { server.run(); });
+
+    // Two adds and a range total in one write; every reply must arrive
+    int fd = connectToTestServer(socketPath);
+    FrameWriter total;
+    total.begin(OP_RANGE_TOTAL);
+    total.putDate("2025-05-01");
+    total.putDate("2025-05-31");
+    total.putString("");
+    string body;
+    bool sent = fd >= 0 && sendAll(fd, addFrame("2025-05-01", 1599, "Food", "Lunch") +
+                                           addFrame("2025-05-02", 5000, "Transport", "Gas") + total.finish());
+    int first = receiveStatus(fd, body);
+    int second = receiveStatus(fd, body);
+    int third = receiveStatus(fd, body);
+    FrameReader totals(body.data() + 1, body.size() - 1);
+    int64_t count = totals.getI64();
+    int64_t cents = totals.getI64();
+    test_assert(sent && first == STATUS_OK && second == STATUS_OK, "Pipelined adds answered without further input");
+    test_assert(third == STATUS_OK && count == 2 && cents == 6599, "Pipelined query sees both adds");
+
+    // The largest add the protocol can describe is accepted
+    sent = sendAll(fd, addFrame("2025-05-03", 100, string(MAX_WIRE_STRING, 'c'), string(MAX_WIRE_STRING, 'd')));
+    test_assert(sent && receiveStatus(fd, body) != -1, "Maximum-size add answered");
+
+    // Invalid values get an error reply and keep the connection
+    sendAll(fd, addFrame("2025-02-30", 100, "Food", "Bad date"));
+    int status = receiveStatus(fd, body);
+    FrameWriter ping;
+    ping.begin(OP_PING);
+    sendAll(fd, ping.finish());
+    test_assert(status == STATUS_ERROR && receiveStatus(fd, body) == STATUS_OK, "Invalid add answered with an error");
+    close(fd);
+
+    // Malformed frames close the connection without a reply
+    string oversized;
+    uint32_t length = MAX_REQUEST_FRAME + 1;
+    for (int i = 0; i < 4; ++i)
+        oversized.push_back(static_cast<char>((length >> (8 * i)) & 0xFF));
+    string truncated = addFrame("2025-05-04", 100, "Food", "Snack");
+    truncated = truncated.substr(0, truncated.size() - 3);
+    truncated[0] = static_cast<char>(truncated.size() - 4);
+    string unknownOpcode("\x01\x00\x00\x00\x63", 5);
+    const string malformed[] = {oversized, truncated, unknownOpcode};
+    bool allClosed = true;
+    for (int i = 0; i < 3; ++i)
+    {
+        fd = connectToTestServer(socketPath);
+        errno = 0;
+        allClosed = allClosed && fd >= 0 && sendAll(fd, malformed[i]) && receiveStatus(fd, body) == -1 && errno != EAGAIN;
+        if (fd >= 0)
+            close(fd);
+    }
+    test_assert(allClosed, "Oversized, truncated and unknown frames close the connection");
+    test_assert(tracker.getCount() == 3, "Only valid adds stored");
 
-    test_assert(tracker.getSize() == 2, "Integration: expense count");
-    test_assert(tracker.countByCategory("Food") == 1, "Integration: category filtering");
-    test_float_equal(65.99f, tracker.getTotalAmount(), "Integration: total calculation");
+    server.stop();
+    runner.join();
+#endif
 }
 
 // ===================================================================
@@ -269,12 +1097,23 @@ int main()
 
     // Run all test suites
     test_date_validation();
+    test_day_numbers();
     test_basic_operations();
     test_invalid_inputs();
     test_filtering();
     test_memory_management();
     test_edge_cases();
     test_integration();
+    test_query_api();
+    test_compact_storage();
+    test_duplicate_import();
+    test_lazy_ledger();
+    test_ledger_import_alerts();
+    test_alert_rules();
+    test_range_totals();
+    test_sorted_views();
+    test_protocol_frames();
+    test_query_server();
 
     // Print summary
     cout << "\n"